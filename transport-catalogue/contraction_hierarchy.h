@@ -0,0 +1,616 @@
+#pragma once
+
+#include "graph.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Contraction hierarchy over a directed weighted graph: vertices are contracted one by one
+// in order of importance, shortcuts preserve shortest distances between the remaining ones.
+// Queries are bidirectional Dijkstra searches which only go up the hierarchy.
+template <typename Weight>
+class ContractionHierarchy {
+private:
+    using IncidenceList = std::vector<EdgeId>;
+
+public:
+    template <typename Graph>
+    explicit ContractionHierarchy(const Graph& graph);
+
+    struct RouteInfo {
+        Weight weight;
+        std::vector<EdgeId> edges;
+    };
+
+    // Edges of the returned route are edges of the source graph
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+
+    // Route weights from every source to every target, row by row, routes are not unpacked.
+    // Bucket-based many-to-many search: the upward search of each target leaves its distance
+    // in the buckets of the vertices it reaches, the upward search of each source combines
+    // its distances with the buckets it meets
+    std::vector<std::optional<Weight>> ComputeWeights(const std::vector<VertexId>& sources,
+                                                      const std::vector<VertexId>& targets) const;
+
+    size_t GetShortcutCount() const {
+        return edges_.size() - original_edge_count_;
+    }
+
+    template <typename Archive>
+    void Save(Archive& archive) const;
+    template <typename Archive>
+    static ContractionHierarchy Load(Archive& archive);
+
+private:
+    ContractionHierarchy() = default;
+
+    // Either an edge of the source graph (same id) or a shortcut of two hierarchy edges
+    struct HierarchyEdge {
+        VertexId from;
+        VertexId to;
+        Weight weight;
+        std::optional<std::pair<EdgeId, EdgeId>> children;
+    };
+
+    struct RouteInternalData {
+        Weight weight;
+        std::optional<EdgeId> prev_edge;
+    };
+
+    struct SearchSide {
+        using QueueItem = std::pair<Weight, VertexId>;
+
+        std::vector<std::optional<RouteInternalData>> routes;
+        std::vector<VertexId> reached_vertices;
+        std::vector<QueueItem> queue;
+
+        void Reset(size_t vertex_count) {
+            for (const VertexId vertex : reached_vertices) {
+                routes[vertex].reset();
+            }
+            reached_vertices.clear();
+            queue.clear();
+            if (routes.size() < vertex_count) {
+                routes.resize(vertex_count);
+            }
+        }
+
+        void Push(VertexId vertex, Weight weight, std::optional<EdgeId> prev_edge) {
+            auto& route = routes[vertex];
+            if (!route) {
+                reached_vertices.push_back(vertex);
+            } else if (!(weight < route->weight)) {
+                return;
+            }
+            route = RouteInternalData{weight, prev_edge};
+            queue.emplace_back(weight, vertex);
+            std::push_heap(queue.begin(), queue.end(), std::greater<QueueItem>{});
+        }
+
+        QueueItem Pop() {
+            std::pop_heap(queue.begin(), queue.end(), std::greater<QueueItem>{});
+            const QueueItem item = queue.back();
+            queue.pop_back();
+            return item;
+        }
+    };
+
+    struct SearchData {
+        SearchSide forward;
+        SearchSide backward;
+    };
+
+    static SearchData& GetThreadSearchData(size_t vertex_count) {
+        thread_local SearchData search_data;
+        search_data.forward.Reset(vertex_count);
+        search_data.backward.Reset(vertex_count);
+        return search_data;
+    }
+
+    class Contractor;
+
+    // Settles every vertex reachable from vertex from in search_graph, routes are not recorded
+    static void SearchAll(SearchSide& side, VertexId from, const CompressedGraph<Weight>& search_graph) {
+        side.Push(from, ZERO_WEIGHT, std::nullopt);
+        while (!side.queue.empty()) {
+            const auto [weight, vertex] = side.Pop();
+            if (side.routes[vertex]->weight < weight) {
+                continue;
+            }
+            for (const EdgeId edge_id : search_graph.GetIncidentEdges(vertex)) {
+                const auto edge = search_graph.GetEdge(edge_id);
+                side.Push(edge.to, weight + edge.weight, std::nullopt);
+            }
+        }
+    }
+
+    void UnpackEdge(EdgeId edge_id, std::vector<EdgeId>& edges) const {
+        std::vector<EdgeId> stack{edge_id};
+        while (!stack.empty()) {
+            const EdgeId id = stack.back();
+            stack.pop_back();
+            if (const auto& children = edges_[id].children) {
+                stack.push_back(children->second);
+                stack.push_back(children->first);
+            } else {
+                edges.push_back(id);
+            }
+        }
+    }
+
+    void BuildSearchGraphs(const std::vector<size_t>& ranks);
+
+    static constexpr Weight ZERO_WEIGHT{};
+    size_t vertex_count_ = 0;
+    size_t original_edge_count_ = 0;
+    std::vector<HierarchyEdge> edges_;
+    // Edges leading from a vertex to a higher ranked one
+    CompressedGraph<Weight> upward_graph_;
+    // Reversed edges leading to a vertex from a higher ranked one
+    CompressedGraph<Weight> downward_graph_;
+    // Ids of hierarchy edges by ids of search graphs edges
+    std::vector<EdgeId> upward_edge_ids_;
+    std::vector<EdgeId> downward_edge_ids_;
+};
+
+template <typename Weight>
+class ContractionHierarchy<Weight>::Contractor {
+public:
+    explicit Contractor(ContractionHierarchy& hierarchy)
+        : hierarchy_(hierarchy)
+        , edges_(hierarchy.edges_)
+        , out_edges_(hierarchy.vertex_count_)
+        , in_edges_(hierarchy.vertex_count_)
+        , contracted_(hierarchy.vertex_count_, false)
+        , contracted_neighbours_(hierarchy.vertex_count_, 0)
+        , levels_(hierarchy.vertex_count_, 0) {
+        for (EdgeId edge_id = 0; edge_id < edges_.size(); ++edge_id) {
+            const auto& edge = edges_[edge_id];
+            if (edge.from != edge.to) {
+                out_edges_[edge.from].push_back(edge_id);
+                in_edges_[edge.to].push_back(edge_id);
+            }
+        }
+    }
+
+    // Returns ranks of vertices in contraction order
+    std::vector<size_t> ContractAll() {
+        const size_t vertex_count = hierarchy_.vertex_count_;
+        std::vector<size_t> ranks(vertex_count);
+
+        using QueueItem = std::pair<int, VertexId>;
+        std::vector<QueueItem> queue;
+        queue.reserve(vertex_count);
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            queue.emplace_back(ComputePriority(vertex), vertex);
+        }
+        std::make_heap(queue.begin(), queue.end(), std::greater<QueueItem>{});
+
+        size_t rank = 0;
+        while (!queue.empty()) {
+            std::pop_heap(queue.begin(), queue.end(), std::greater<QueueItem>{});
+            const VertexId vertex = queue.back().second;
+            queue.pop_back();
+
+            // Lazy update: the priority may have grown since the vertex was queued
+            const int priority = ComputePriority(vertex);
+            if (!queue.empty() && priority > queue.front().first) {
+                queue.emplace_back(priority, vertex);
+                std::push_heap(queue.begin(), queue.end(), std::greater<QueueItem>{});
+                continue;
+            }
+
+            Contract(vertex);
+            ranks[vertex] = rank++;
+        }
+        return ranks;
+    }
+
+private:
+    struct Shortcut {
+        VertexId from;
+        VertexId to;
+        Weight weight;
+        EdgeId first;
+        EdgeId second;
+    };
+
+    // Lightest remaining edge to every neighbour, in ascending neighbour order
+    std::vector<EdgeId> GetNeighbourEdges(const IncidenceList& incidence_list, VertexId vertex,
+                                          bool outgoing) const {
+        std::vector<EdgeId> result;
+        for (const EdgeId edge_id : incidence_list) {
+            const auto& edge = edges_[edge_id];
+            const VertexId neighbour = outgoing ? edge.to : edge.from;
+            if (neighbour != vertex && !contracted_[neighbour]) {
+                result.push_back(edge_id);
+            }
+        }
+        const auto neighbour_of = [this, outgoing](EdgeId edge_id) {
+            return outgoing ? edges_[edge_id].to : edges_[edge_id].from;
+        };
+        std::sort(result.begin(), result.end(), [this, &neighbour_of](EdgeId lhs, EdgeId rhs) {
+            return std::pair{neighbour_of(lhs), edges_[lhs].weight}
+                 < std::pair{neighbour_of(rhs), edges_[rhs].weight};
+        });
+        result.erase(std::unique(result.begin(), result.end(),
+                                 [&neighbour_of](EdgeId lhs, EdgeId rhs) {
+                                     return neighbour_of(lhs) == neighbour_of(rhs);
+                                 }),
+                     result.end());
+        return result;
+    }
+
+    // Bounded Dijkstra over not contracted vertices, ignoring the vertex being contracted
+    void RunWitnessSearch(VertexId source, VertexId ignored, Weight max_weight, size_t max_settled) {
+        witness_.Reset(hierarchy_.vertex_count_);
+        witness_.Push(source, ZERO_WEIGHT, std::nullopt);
+
+        size_t settled_count = 0;
+        while (!witness_.queue.empty() && settled_count < max_settled) {
+            const auto [weight, vertex] = witness_.Pop();
+            if (witness_.routes[vertex]->weight < weight) {
+                continue;
+            }
+            if (max_weight < weight) {
+                break;
+            }
+            ++settled_count;
+            for (const EdgeId edge_id : out_edges_[vertex]) {
+                const auto& edge = edges_[edge_id];
+                if (edge.to != ignored && !contracted_[edge.to]) {
+                    witness_.Push(edge.to, weight + edge.weight, edge_id);
+                }
+            }
+        }
+    }
+
+    std::vector<Shortcut> FindShortcuts(VertexId vertex, size_t max_settled) {
+        std::vector<Shortcut> shortcuts;
+        const auto in_edges = GetNeighbourEdges(in_edges_[vertex], vertex, false);
+        const auto out_edges = GetNeighbourEdges(out_edges_[vertex], vertex, true);
+        if (in_edges.empty() || out_edges.empty()) {
+            return shortcuts;
+        }
+
+        Weight max_out_weight = ZERO_WEIGHT;
+        for (const EdgeId out_id : out_edges) {
+            max_out_weight = std::max(max_out_weight, edges_[out_id].weight);
+        }
+
+        for (const EdgeId in_id : in_edges) {
+            const auto& in_edge = edges_[in_id];
+            RunWitnessSearch(in_edge.from, vertex, in_edge.weight + max_out_weight, max_settled);
+
+            for (const EdgeId out_id : out_edges) {
+                const auto& out_edge = edges_[out_id];
+                if (out_edge.to == in_edge.from) {
+                    continue;
+                }
+                const Weight via_weight = in_edge.weight + out_edge.weight;
+                const auto& witness = witness_.routes[out_edge.to];
+                if (witness && !(via_weight < witness->weight)) {
+                    continue;
+                }
+                shortcuts.push_back({in_edge.from, out_edge.to, via_weight, in_id, out_id});
+            }
+        }
+        return shortcuts;
+    }
+
+    // Edge difference, number of contracted neighbours and hierarchy depth of the vertex
+    int ComputePriority(VertexId vertex) {
+        const int removed_count = static_cast<int>(
+            GetNeighbourEdges(in_edges_[vertex], vertex, false).size()
+            + GetNeighbourEdges(out_edges_[vertex], vertex, true).size());
+        const int added_count = static_cast<int>(FindShortcuts(vertex, MAX_ESTIMATE_SETTLED).size());
+        return 2 * (added_count - removed_count) + contracted_neighbours_[vertex] + levels_[vertex];
+    }
+
+    void Contract(VertexId vertex) {
+        for (const Shortcut& shortcut : FindShortcuts(vertex, MAX_CONTRACT_SETTLED)) {
+            edges_.push_back(HierarchyEdge{shortcut.from, shortcut.to, shortcut.weight,
+                                           std::pair{shortcut.first, shortcut.second}});
+            const EdgeId edge_id = edges_.size() - 1;
+            out_edges_[shortcut.from].push_back(edge_id);
+            in_edges_[shortcut.to].push_back(edge_id);
+        }
+
+        contracted_[vertex] = true;
+        const auto update_neighbour = [this, vertex](VertexId neighbour) {
+            ++contracted_neighbours_[neighbour];
+            levels_[neighbour] = std::max(levels_[neighbour], levels_[vertex] + 1);
+        };
+        for (const EdgeId edge_id : out_edges_[vertex]) {
+            update_neighbour(edges_[edge_id].to);
+        }
+        for (const EdgeId edge_id : in_edges_[vertex]) {
+            update_neighbour(edges_[edge_id].from);
+        }
+    }
+
+    // Witness searches are cut off early: a missed witness only costs an extra shortcut
+    static constexpr size_t MAX_ESTIMATE_SETTLED = 50;
+    static constexpr size_t MAX_CONTRACT_SETTLED = 200;
+
+    ContractionHierarchy& hierarchy_;
+    std::vector<HierarchyEdge>& edges_;
+    std::vector<IncidenceList> out_edges_;
+    std::vector<IncidenceList> in_edges_;
+    std::vector<bool> contracted_;
+    std::vector<int> contracted_neighbours_;
+    std::vector<int> levels_;
+    SearchSide witness_;
+};
+
+template <typename Weight>
+template <typename Graph>
+ContractionHierarchy<Weight>::ContractionHierarchy(const Graph& graph)
+    : vertex_count_(graph.GetVertexCount())
+    , original_edge_count_(graph.GetEdgeCount())
+{
+    edges_.reserve(original_edge_count_);
+    for (EdgeId edge_id = 0; edge_id < original_edge_count_; ++edge_id) {
+        const auto& edge = graph.GetEdge(edge_id);
+        if (edge.weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+        edges_.push_back(HierarchyEdge{edge.from, edge.to, edge.weight, std::nullopt});
+    }
+
+    BuildSearchGraphs(Contractor(*this).ContractAll());
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::BuildSearchGraphs(const std::vector<size_t>& ranks) {
+    DirectedWeightedGraph<Weight> upward_graph(vertex_count_);
+    DirectedWeightedGraph<Weight> downward_graph(vertex_count_);
+    std::vector<EdgeId> upward_edge_ids;
+    std::vector<EdgeId> downward_edge_ids;
+
+    for (EdgeId edge_id = 0; edge_id < edges_.size(); ++edge_id) {
+        const auto& edge = edges_[edge_id];
+        if (ranks[edge.from] < ranks[edge.to]) {
+            upward_graph.AddEdge({edge.from, edge.to, edge.weight});
+            upward_edge_ids.push_back(edge_id);
+        } else if (ranks[edge.to] < ranks[edge.from]) {
+            downward_graph.AddEdge({edge.to, edge.from, edge.weight});
+            downward_edge_ids.push_back(edge_id);
+        }
+    }
+
+    const auto compress = [](const DirectedWeightedGraph<Weight>& graph,
+                             const std::vector<EdgeId>& hierarchy_edge_ids,
+                             CompressedGraph<Weight>& compressed_graph,
+                             std::vector<EdgeId>& compressed_edge_ids) {
+        std::vector<EdgeId> new_edge_ids;
+        compressed_graph = CompressedGraph<Weight>(graph, new_edge_ids);
+        compressed_edge_ids.resize(new_edge_ids.size());
+        for (EdgeId edge_id = 0; edge_id < new_edge_ids.size(); ++edge_id) {
+            compressed_edge_ids[new_edge_ids[edge_id]] = hierarchy_edge_ids[edge_id];
+        }
+    };
+    compress(upward_graph, upward_edge_ids, upward_graph_, upward_edge_ids_);
+    compress(downward_graph, downward_edge_ids, downward_graph_, downward_edge_ids_);
+}
+
+template <typename Weight>
+template <typename Archive>
+void ContractionHierarchy<Weight>::Save(Archive& archive) const {
+    archive.Write(static_cast<uint64_t>(vertex_count_));
+    archive.Write(static_cast<uint64_t>(original_edge_count_));
+    archive.Write(static_cast<uint64_t>(edges_.size()));
+    for (const auto& edge : edges_) {
+        archive.Write(static_cast<uint64_t>(edge.from));
+        archive.Write(static_cast<uint64_t>(edge.to));
+        archive.Write(edge.weight);
+        archive.Write(edge.children.has_value());
+        if (edge.children) {
+            archive.Write(static_cast<uint64_t>(edge.children->first));
+            archive.Write(static_cast<uint64_t>(edge.children->second));
+        }
+    }
+    upward_graph_.Save(archive);
+    downward_graph_.Save(archive);
+    archive.WriteVector(upward_edge_ids_);
+    archive.WriteVector(downward_edge_ids_);
+}
+
+template <typename Weight>
+template <typename Archive>
+ContractionHierarchy<Weight> ContractionHierarchy<Weight>::Load(Archive& archive) {
+    ContractionHierarchy hierarchy;
+    hierarchy.vertex_count_ = archive.template Read<uint64_t>();
+    hierarchy.original_edge_count_ = archive.template Read<uint64_t>();
+    hierarchy.edges_.resize(archive.template Read<uint64_t>());
+    for (auto& edge : hierarchy.edges_) {
+        edge.from = archive.template Read<uint64_t>();
+        edge.to = archive.template Read<uint64_t>();
+        edge.weight = archive.template Read<Weight>();
+        if (archive.template Read<bool>()) {
+            const EdgeId first = archive.template Read<uint64_t>();
+            const EdgeId second = archive.template Read<uint64_t>();
+            edge.children.emplace(first, second);
+        }
+    }
+    hierarchy.upward_graph_ = CompressedGraph<Weight>::Load(archive);
+    hierarchy.downward_graph_ = CompressedGraph<Weight>::Load(archive);
+    hierarchy.upward_edge_ids_ = archive.template ReadVector<EdgeId>();
+    hierarchy.downward_edge_ids_ = archive.template ReadVector<EdgeId>();
+
+    // Shortcuts are added after the edges they consist of, so unpacking always reaches
+    // original edges; edge ends and ids index per-vertex and per-edge arrays of queries
+    const size_t edge_count = hierarchy.edges_.size();
+    bool is_consistent = hierarchy.original_edge_count_ <= edge_count
+                      && hierarchy.upward_graph_.GetVertexCount() == hierarchy.vertex_count_
+                      && hierarchy.downward_graph_.GetVertexCount() == hierarchy.vertex_count_
+                      && hierarchy.upward_edge_ids_.size() == hierarchy.upward_graph_.GetEdgeCount()
+                      && hierarchy.downward_edge_ids_.size() == hierarchy.downward_graph_.GetEdgeCount();
+    for (EdgeId edge_id = 0; is_consistent && edge_id < edge_count; ++edge_id) {
+        const HierarchyEdge& edge = hierarchy.edges_[edge_id];
+        is_consistent = edge.from < hierarchy.vertex_count_ && edge.to < hierarchy.vertex_count_
+                     && (edge_id < hierarchy.original_edge_count_) != edge.children.has_value()
+                     && (!edge.children || (edge.children->first < edge_id && edge.children->second < edge_id));
+    }
+    const auto is_edge = [edge_count](EdgeId edge_id) {
+        return edge_id < edge_count;
+    };
+    if (!is_consistent
+        || !std::all_of(hierarchy.upward_edge_ids_.begin(), hierarchy.upward_edge_ids_.end(), is_edge)
+        || !std::all_of(hierarchy.downward_edge_ids_.begin(), hierarchy.downward_edge_ids_.end(), is_edge)) {
+        throw std::invalid_argument("Inconsistent contraction hierarchy data");
+    }
+    return hierarchy;
+}
+
+template <typename Weight>
+std::optional<typename ContractionHierarchy<Weight>::RouteInfo>
+ContractionHierarchy<Weight>::BuildRoute(VertexId from, VertexId to) const {
+    if (from >= vertex_count_ || to >= vertex_count_) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    SearchData& data = GetThreadSearchData(vertex_count_);
+    SearchSide& forward = data.forward;
+    SearchSide& backward = data.backward;
+    forward.Push(from, ZERO_WEIGHT, std::nullopt);
+    backward.Push(to, ZERO_WEIGHT, std::nullopt);
+
+    std::optional<Weight> best_weight;
+    VertexId meeting_vertex = from;
+
+    const auto step = [this, &best_weight, &meeting_vertex](SearchSide& side,
+                                                            const SearchSide& other_side,
+                                                            bool is_forward) {
+        const auto [weight, vertex] = side.Pop();
+        if (side.routes[vertex]->weight < weight) {
+            return;
+        }
+        if (best_weight && !(weight < *best_weight)) {
+            side.queue.clear();
+            return;
+        }
+        if (const auto& other_route = other_side.routes[vertex]) {
+            const Weight candidate_weight = weight + other_route->weight;
+            if (!best_weight || candidate_weight < *best_weight) {
+                best_weight = candidate_weight;
+                meeting_vertex = vertex;
+            }
+        }
+        const auto& search_graph = is_forward ? upward_graph_ : downward_graph_;
+        const auto& hierarchy_edge_ids = is_forward ? upward_edge_ids_ : downward_edge_ids_;
+        for (const EdgeId edge_id : search_graph.GetIncidentEdges(vertex)) {
+            const auto edge = search_graph.GetEdge(edge_id);
+            side.Push(edge.to, weight + edge.weight, hierarchy_edge_ids[edge_id]);
+        }
+    };
+
+    while (!forward.queue.empty() || !backward.queue.empty()) {
+        const bool is_forward = backward.queue.empty()
+            || (!forward.queue.empty() && !(backward.queue.front().first < forward.queue.front().first));
+        if (is_forward) {
+            step(forward, backward, true);
+        } else {
+            step(backward, forward, false);
+        }
+    }
+
+    if (!best_weight) {
+        return std::nullopt;
+    }
+
+    std::vector<EdgeId> hierarchy_edges;
+    for (std::optional<EdgeId> edge_id = forward.routes[meeting_vertex]->prev_edge;
+         edge_id;
+         edge_id = forward.routes[edges_[*edge_id].from]->prev_edge)
+    {
+        hierarchy_edges.push_back(*edge_id);
+    }
+    std::reverse(hierarchy_edges.begin(), hierarchy_edges.end());
+    for (std::optional<EdgeId> edge_id = backward.routes[meeting_vertex]->prev_edge;
+         edge_id;
+         edge_id = backward.routes[edges_[*edge_id].to]->prev_edge)
+    {
+        hierarchy_edges.push_back(*edge_id);
+    }
+
+    std::vector<EdgeId> edges;
+    for (const EdgeId edge_id : hierarchy_edges) {
+        UnpackEdge(edge_id, edges);
+    }
+
+    return RouteInfo{*best_weight, std::move(edges)};
+}
+
+template <typename Weight>
+std::vector<std::optional<Weight>>
+ContractionHierarchy<Weight>::ComputeWeights(const std::vector<VertexId>& sources,
+                                             const std::vector<VertexId>& targets) const {
+    const auto is_out_of_range = [this](VertexId vertex) {
+        return vertex >= vertex_count_;
+    };
+    if (std::any_of(sources.begin(), sources.end(), is_out_of_range)
+        || std::any_of(targets.begin(), targets.end(), is_out_of_range)) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    struct BucketEntry {
+        size_t target_idx;
+        Weight weight;
+    };
+
+    SearchData& data = GetThreadSearchData(vertex_count_);
+    SearchSide& search = data.backward;
+
+    // Buckets in compressed sparse row layout: entries of vertex v are
+    // bucket_entries[bucket_offsets[v] .. bucket_offsets[v + 1])
+    std::vector<std::pair<VertexId, BucketEntry>> reached;
+    for (size_t target_idx = 0; target_idx < targets.size(); ++target_idx) {
+        search.Reset(vertex_count_);
+        SearchAll(search, targets[target_idx], downward_graph_);
+        for (const VertexId vertex : search.reached_vertices) {
+            reached.push_back({vertex, {target_idx, search.routes[vertex]->weight}});
+        }
+    }
+    std::vector<size_t> bucket_offsets(vertex_count_ + 1, 0);
+    for (const auto& [vertex, entry] : reached) {
+        ++bucket_offsets[vertex + 1];
+    }
+    for (size_t vertex = 1; vertex <= vertex_count_; ++vertex) {
+        bucket_offsets[vertex] += bucket_offsets[vertex - 1];
+    }
+    std::vector<BucketEntry> bucket_entries(reached.size());
+    std::vector<size_t> filled(bucket_offsets.begin(), bucket_offsets.end() - 1);
+    for (const auto& [vertex, entry] : reached) {
+        bucket_entries[filled[vertex]++] = entry;
+    }
+    reached = {};
+
+    std::vector<std::optional<Weight>> weights(sources.size() * targets.size());
+    for (size_t source_idx = 0; source_idx < sources.size(); ++source_idx) {
+        search.Reset(vertex_count_);
+        SearchAll(search, sources[source_idx], upward_graph_);
+        std::optional<Weight>* weights_from = weights.data() + source_idx * targets.size();
+        for (const VertexId vertex : search.reached_vertices) {
+            const Weight weight = search.routes[vertex]->weight;
+            for (size_t idx = bucket_offsets[vertex]; idx < bucket_offsets[vertex + 1]; ++idx) {
+                const BucketEntry& entry = bucket_entries[idx];
+                const Weight candidate_weight = weight + entry.weight;
+                auto& target_weight = weights_from[entry.target_idx];
+                if (!target_weight || candidate_weight < *target_weight) {
+                    target_weight = candidate_weight;
+                }
+            }
+        }
+    }
+    return weights;
+}
+
+}  // namespace graph
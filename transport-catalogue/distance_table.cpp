@@ -0,0 +1,73 @@
+#include "distance_table.h"
+
+namespace transport::detail {
+
+namespace {
+
+// Перемешивание splitmix64: соседние номера остановок дают далёкие друг от друга хеши
+uint64_t MixHash(uint64_t value) {
+    value ^= value >> 30;
+    value *= 0xBF58476D1CE4E5B9ULL;
+    value ^= value >> 27;
+    value *= 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+} // namespace
+
+void DistanceTable::Set(StopId from, StopId to, double distance) {
+    const uint64_t key = MakeKey(from, to);
+    size_t pos = slots_.empty() ? 0 : FindSlot(key);
+    if (slots_.empty() || slots_[pos].key == EMPTY_KEY) {
+        // Таблица заполнена не больше чем наполовину, иначе цепочки проб растут.
+        // Замена расстояния у существующего ключа таблицу не увеличивает
+        if ((size_ + 1) * 2 > slots_.size()) {
+            Grow();
+            pos = FindSlot(key);
+        }
+        slots_[pos].key = key;
+        ++size_;
+    }
+    slots_[pos].distance = distance;
+}
+
+std::optional<double> DistanceTable::Find(StopId from, StopId to) const {
+    if (slots_.empty()) {
+        return std::nullopt;
+    }
+    const auto& slot = slots_[FindSlot(MakeKey(from, to))];
+    if (slot.key == EMPTY_KEY) {
+        return std::nullopt;
+    }
+    return slot.distance;
+}
+
+size_t DistanceTable::GetSize() const {
+    return size_;
+}
+
+uint64_t DistanceTable::MakeKey(StopId from, StopId to) {
+    return (static_cast<uint64_t>(from) << 32) | to;
+}
+
+// Слот с ключом key или пустой слот, в который его нужно записать
+size_t DistanceTable::FindSlot(uint64_t key) const {
+    const size_t mask = slots_.size() - 1;
+    size_t pos = MixHash(key) & mask;
+    while (slots_[pos].key != key && slots_[pos].key != EMPTY_KEY) {
+        pos = (pos + 1) & mask;
+    }
+    return pos;
+}
+
+void DistanceTable::Grow() {
+    std::vector<Slot> old_slots(slots_.empty() ? 16 : slots_.size() * 2, Slot{ EMPTY_KEY, 0.0 });
+    old_slots.swap(slots_);
+    for (const auto& slot : old_slots) {
+        if (slot.key != EMPTY_KEY) {
+            slots_[FindSlot(slot.key)] = slot;
+        }
+    }
+}
+
+} // end namespace transport::detail
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "domain.h"
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace transport::detail {
+
+// Расстояния по дорогам между парами остановок. Открытая адресация с линейным
+// пробированием: пары лежат в одном массиве, поиск не ходит по узлам списков
+class DistanceTable {
+public:
+    void Set(StopId from, StopId to, double distance);
+    // Расстояние, заданное именно в направлении from -> to
+    std::optional<double> Find(StopId from, StopId to) const;
+    size_t GetSize() const;
+
+    // Вызывает callback(from, to, distance) для каждой заданной пары
+    template <typename Callback>
+    void ForEach(Callback&& callback) const {
+        for (const auto& slot : slots_) {
+            if (slot.key != EMPTY_KEY) {
+                callback(static_cast<StopId>(slot.key >> 32), static_cast<StopId>(slot.key), slot.distance);
+            }
+        }
+    }
+
+private:
+    struct Slot {
+        uint64_t key;
+        double distance;
+    };
+
+    // Пара с обоими номерами 0xFFFFFFFF не встречается: столько остановок не бывает
+    static constexpr uint64_t EMPTY_KEY = ~uint64_t{ 0 };
+
+    static uint64_t MakeKey(StopId from, StopId to);
+    size_t FindSlot(uint64_t key) const;
+    void Grow();
+
+    std::vector<Slot> slots_;
+    size_t size_ = 0;
+};
+
+} // end namespace transport::detail
@@ -4,7 +4,8 @@ namespace transport {
 namespace detail {
 
 Stop::Stop(std::string stop_name, double latitude, double longitude)
-    : name(std::move(stop_name)), coordinates({ latitude, longitude }) {}
+    : name(std::move(stop_name)), coordinates({ latitude, longitude })
+    , trig_coordinates(coordinates) {}
 
 namespace bus {
 
@@ -32,19 +33,5 @@ size_t Hasher::operator()(const std::string_view& str) const {
     return std::hash<std::string>()(std::string(str));
 }
 
-size_t Hasher::operator()(const std::pair<Stop*, Stop*>& stops) const {
-    size_t hash1 = std::hash<Stop*>()(stops.first);
-    size_t hash2 = std::hash<Stop*>()(stops.second);
-    return hash1 ^ (hash2 << 1); // XOR   
-}
-
-size_t Hasher::operator()(const bus::Bus* bus) const {
-    return std::hash<std::string_view>()(bus->name);
-}
-
-size_t Hasher::operator()(const Stop* stop) const {
-    return std::hash<std::string_view>()(stop->name);
-}
-
 } // end namespace detail
 } // end namespace transport
\ No newline at end of file
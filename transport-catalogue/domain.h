@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -8,12 +9,22 @@
 namespace transport {
 namespace detail {
 
+using StopId = uint32_t;
+using BusId = uint32_t;
+
 struct Stop {
     Stop() = default;
     Stop(std::string stop_name, double latitude, double longitude);
 
+    StopId id = 0;
     std::string name;
     geo::Coordinates coordinates;
+    geo::TrigCoordinates trig_coordinates;
+};
+
+struct StopTime {
+    const Stop* stop;
+    double time;
 };
 
 namespace bus {
@@ -23,10 +34,13 @@ struct Bus {
     Bus(std::string bus_name, std::vector<Stop*> bus_stops, std::vector<Stop*> fin_stops, bool is_round);
     bool operator<(Bus& other);
 
+    BusId id = 0;
     std::string name;
     std::vector<Stop*> stops; 
     std::vector<Stop*> final_stops; 
     bool is_roundtrip;
+    bool is_removed = false;
+    std::vector<double> departures;
 };
 
 struct Info {
@@ -44,9 +58,6 @@ struct PtrComparator {
 
 struct Hasher {
     size_t operator()(const std::string_view& str) const;
-    size_t operator()(const std::pair<Stop*, Stop*>& stops) const;
-    size_t operator()(const bus::Bus* bus) const;
-    size_t operator()(const Stop* stop) const;
 };
 
 } // end namespace detail
@@ -5,13 +5,53 @@
 
 namespace geo {
 
+namespace {
+
+const double dr = M_PI / 180.0;
+const double earth_radius = 6371000; //  
+
+}  // namespace
+
 double ComputeDistance(Coordinates from, Coordinates to) {
     using namespace std;
-    const double dr = M_PI / 180.0;
-    const double earth_radius = 6371000; //  
     return acos(sin(from.lat * dr) * sin(to.lat * dr)
                 + cos(from.lat * dr) * cos(to.lat * dr) * cos(abs(from.lng - to.lng) * dr))
         * earth_radius;
 }
 
+TrigCoordinates::TrigCoordinates(Coordinates coordinates)
+    : sin_lat(std::sin(coordinates.lat * dr))
+    , cos_lat(std::cos(coordinates.lat * dr))
+    , lng(coordinates.lng) {
+}
+
+//   ,   ,     
+double ComputeDistance(const TrigCoordinates& from, const TrigCoordinates& to) {
+    using namespace std;
+    return acos(from.sin_lat * to.sin_lat
+                + from.cos_lat * to.cos_lat * cos(abs(from.lng - to.lng) * dr))
+        * earth_radius;
+}
+
+std::vector<double> ComputePathDistances(const std::vector<TrigCoordinates>& points) {
+    std::vector<double> result;
+    if (points.size() < 2) {
+        return result;
+    }
+    result.reserve(points.size() - 1);
+    for (size_t i = 0; i + 1 < points.size(); ++i) {
+        result.push_back(ComputeDistance(points[i], points[i + 1]));
+    }
+    return result;
+}
+
+std::vector<double> ComputeDistances(const TrigCoordinates& from, const std::vector<TrigCoordinates>& points) {
+    std::vector<double> result;
+    result.reserve(points.size());
+    for (const auto& point : points) {
+        result.push_back(ComputeDistance(from, point));
+    }
+    return result;
+}
+
 }  // namespace geo
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <vector>
+
 namespace geo {
 
 struct Coordinates {
@@ -7,6 +9,23 @@ struct Coordinates {
     double lng; // 
 };
 
+//        .
+//      ,   ComputeDistance,     
+struct TrigCoordinates {
+    TrigCoordinates() = default;
+    explicit TrigCoordinates(Coordinates coordinates);
+
+    double sin_lat = 0;
+    double cos_lat = 1;
+    double lng = 0;
+};
+
 double ComputeDistance(Coordinates from, Coordinates to);
+double ComputeDistance(const TrigCoordinates& from, const TrigCoordinates& to);
+
+//    : result[i] -  points[i]  points[i + 1]
+std::vector<double> ComputePathDistances(const std::vector<TrigCoordinates>& points);
+//   from    points
+std::vector<double> ComputeDistances(const TrigCoordinates& from, const std::vector<TrigCoordinates>& points);
 
 }  // namespace geo
\ No newline at end of file
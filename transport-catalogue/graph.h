@@ -2,7 +2,11 @@
 
 #include "ranges.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <cstdlib>
+#include <limits>
+#include <stdexcept>
 #include <vector>
 
 namespace graph {
@@ -38,6 +42,39 @@ private:
     std::vector<IncidenceList> incidence_lists_;
 };
 
+// Immutable graph in compressed sparse row layout. Edges are renumbered so that edges
+// leaving one vertex have consecutive ids, their ends and weights are stored in flat arrays
+template <typename Weight>
+class CompressedGraph {
+private:
+    using IncidentEdgesRange = ranges::Range<ranges::CountingIterator<EdgeId>>;
+
+public:
+    CompressedGraph() = default;
+    explicit CompressedGraph(const DirectedWeightedGraph<Weight>& graph);
+    // new_edge_ids[id] receives the id given to the edge id of the source graph
+    CompressedGraph(const DirectedWeightedGraph<Weight>& graph, std::vector<EdgeId>& new_edge_ids);
+
+    size_t GetVertexCount() const;
+    size_t GetEdgeCount() const;
+    Edge<Weight> GetEdge(EdgeId edge_id) const;
+    IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
+
+    // Archive provides Write/WriteVector and Read/ReadVector of trivially copyable values
+    template <typename Archive>
+    void Save(Archive& archive) const;
+    template <typename Archive>
+    static CompressedGraph Load(Archive& archive);
+
+private:
+    using StoredId = uint32_t;
+
+    std::vector<StoredId> offsets_;
+    std::vector<StoredId> sources_;
+    std::vector<StoredId> targets_;
+    std::vector<Weight> weights_;
+};
+
 template <typename Weight>
 DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count)
     : incidence_lists_(vertex_count) {
@@ -71,4 +108,100 @@ typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
 DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
     return ranges::AsRange(incidence_lists_.at(vertex));
 }
+
+template <typename Weight>
+CompressedGraph<Weight>::CompressedGraph(const DirectedWeightedGraph<Weight>& graph) {
+    std::vector<EdgeId> new_edge_ids;
+    *this = CompressedGraph(graph, new_edge_ids);
+}
+
+template <typename Weight>
+CompressedGraph<Weight>::CompressedGraph(const DirectedWeightedGraph<Weight>& graph,
+                                         std::vector<EdgeId>& new_edge_ids) {
+    const size_t vertex_count = graph.GetVertexCount();
+    const size_t edge_count = graph.GetEdgeCount();
+    if (vertex_count >= std::numeric_limits<StoredId>::max()
+        || edge_count >= std::numeric_limits<StoredId>::max()) {
+        throw std::length_error("Graph is too large for compressed layout");
+    }
+
+    offsets_.resize(vertex_count + 1);
+    sources_.resize(edge_count);
+    targets_.resize(edge_count);
+    weights_.resize(edge_count);
+    new_edge_ids.assign(edge_count, 0);
+
+    EdgeId new_edge_id = 0;
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        offsets_[vertex] = static_cast<StoredId>(new_edge_id);
+        for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+            const auto& edge = graph.GetEdge(edge_id);
+            sources_[new_edge_id] = static_cast<StoredId>(edge.from);
+            targets_[new_edge_id] = static_cast<StoredId>(edge.to);
+            weights_[new_edge_id] = edge.weight;
+            new_edge_ids[edge_id] = new_edge_id++;
+        }
+    }
+    offsets_[vertex_count] = static_cast<StoredId>(new_edge_id);
+}
+
+template <typename Weight>
+size_t CompressedGraph<Weight>::GetVertexCount() const {
+    return offsets_.empty() ? 0 : offsets_.size() - 1;
+}
+
+template <typename Weight>
+size_t CompressedGraph<Weight>::GetEdgeCount() const {
+    return targets_.size();
+}
+
+template <typename Weight>
+Edge<Weight> CompressedGraph<Weight>::GetEdge(EdgeId edge_id) const {
+    return {sources_.at(edge_id), targets_[edge_id], weights_[edge_id]};
+}
+
+template <typename Weight>
+typename CompressedGraph<Weight>::IncidentEdgesRange
+CompressedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
+    if (vertex >= GetVertexCount()) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    return ranges::AsCountingRange<EdgeId>(offsets_[vertex], offsets_[vertex + 1]);
+}
+
+template <typename Weight>
+template <typename Archive>
+void CompressedGraph<Weight>::Save(Archive& archive) const {
+    archive.WriteVector(offsets_);
+    archive.WriteVector(sources_);
+    archive.WriteVector(targets_);
+    archive.WriteVector(weights_);
+}
+
+template <typename Weight>
+template <typename Archive>
+CompressedGraph<Weight> CompressedGraph<Weight>::Load(Archive& archive) {
+    CompressedGraph graph;
+    graph.offsets_ = archive.template ReadVector<StoredId>();
+    graph.sources_ = archive.template ReadVector<StoredId>();
+    graph.targets_ = archive.template ReadVector<StoredId>();
+    graph.weights_ = archive.template ReadVector<Weight>();
+
+    const size_t edge_count = graph.targets_.size();
+    const bool is_consistent = !graph.offsets_.empty()
+                            && graph.offsets_.back() == edge_count
+                            && graph.sources_.size() == edge_count
+                            && graph.weights_.size() == edge_count
+                            && std::is_sorted(graph.offsets_.begin(), graph.offsets_.end());
+    // Edge ends index per-vertex data of routers, a corrupt end must not reach them
+    const auto is_vertex = [vertex_count = graph.GetVertexCount()](StoredId vertex) {
+        return vertex < vertex_count;
+    };
+    if (!is_consistent || !std::all_of(graph.sources_.begin(), graph.sources_.end(), is_vertex)
+        || !std::all_of(graph.targets_.begin(), graph.targets_.end(), is_vertex)) {
+        throw std::invalid_argument("Inconsistent compressed graph data");
+    }
+    return graph;
+}
+
 }  // namespace graph
\ No newline at end of file
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace spatial {
+
+// Axis-aligned rectangle, borders are inclusive
+struct Rect {
+    double min_x = 0;
+    double min_y = 0;
+    double max_x = 0;
+    double max_y = 0;
+
+    bool Intersects(const Rect& other) const {
+        return min_x <= other.max_x && other.min_x <= max_x
+            && min_y <= other.max_y && other.min_y <= max_y;
+    }
+
+    void Extend(const Rect& other) {
+        min_x = std::min(min_x, other.min_x);
+        min_y = std::min(min_y, other.min_y);
+        max_x = std::max(max_x, other.max_x);
+        max_y = std::max(max_y, other.max_y);
+    }
+};
+
+// Immutable uniform grid over rectangles tagged with item ids. An item may be
+// described by several rectangles (e.g. one per polyline segment), each rectangle is
+// stored in every cell it overlaps. Cells are kept in compressed sparse row layout
+class GridIndex {
+public:
+    struct Entry {
+        size_t id;
+        Rect box;
+    };
+
+    GridIndex() = default;
+    explicit GridIndex(std::vector<Entry> entries);
+
+    // Ids of items having a rectangle that intersects area, in increasing order
+    std::vector<size_t> Query(const Rect& area) const;
+
+private:
+    struct CellRange {
+        size_t min_column;
+        size_t min_row;
+        size_t max_column;
+        size_t max_row;
+    };
+
+    CellRange GetCells(const Rect& box) const;
+    size_t ToColumn(double x) const;
+    size_t ToRow(double y) const;
+
+    std::vector<Entry> entries_;
+    Rect bounds_;
+    size_t columns_ = 0;
+    size_t rows_ = 0;
+    double cell_width_ = 1;
+    double cell_height_ = 1;
+    // Entries of cell c are cell_entries_[cell_offsets_[c] .. cell_offsets_[c + 1])
+    std::vector<uint32_t> cell_offsets_;
+    std::vector<uint32_t> cell_entries_;
+};
+
+inline GridIndex::GridIndex(std::vector<Entry> entries)
+    : entries_(std::move(entries)) {
+    if (entries_.empty()) {
+        return;
+    }
+
+    bounds_ = entries_.front().box;
+    double mean_width = 0;
+    double mean_height = 0;
+    for (const auto& entry : entries_) {
+        bounds_.Extend(entry.box);
+        mean_width += (entry.box.max_x - entry.box.min_x) / entries_.size();
+        mean_height += (entry.box.max_y - entry.box.min_y) / entries_.size();
+    }
+
+    // About one entry per cell on average, but cells are not smaller than a typical
+    // rectangle: otherwise every rectangle would be copied into many cells
+    const double width = bounds_.max_x - bounds_.min_x;
+    const double height = bounds_.max_y - bounds_.min_y;
+    const double side = std::ceil(std::sqrt(static_cast<double>(entries_.size())));
+    cell_width_ = std::max({ width / side, mean_width, 1e-9 });
+    cell_height_ = std::max({ height / side, mean_height, 1e-9 });
+    columns_ = static_cast<size_t>(std::clamp(std::ceil(width / cell_width_), 1.0, 1024.0));
+    rows_ = static_cast<size_t>(std::clamp(std::ceil(height / cell_height_), 1.0, 1024.0));
+    cell_width_ = std::max(width / columns_, 1e-9);
+    cell_height_ = std::max(height / rows_, 1e-9);
+
+    // Counting pass, then placement pass
+    cell_offsets_.assign(columns_ * rows_ + 1, 0);
+    for (const auto& entry : entries_) {
+        const auto cells = GetCells(entry.box);
+        for (size_t row = cells.min_row; row <= cells.max_row; ++row) {
+            for (size_t column = cells.min_column; column <= cells.max_column; ++column) {
+                ++cell_offsets_[row * columns_ + column + 1];
+            }
+        }
+    }
+    for (size_t cell = 1; cell < cell_offsets_.size(); ++cell) {
+        cell_offsets_[cell] += cell_offsets_[cell - 1];
+    }
+
+    cell_entries_.resize(cell_offsets_.back());
+    std::vector<uint32_t> filled(cell_offsets_.begin(), cell_offsets_.end() - 1);
+    for (size_t idx = 0; idx < entries_.size(); ++idx) {
+        const auto cells = GetCells(entries_[idx].box);
+        for (size_t row = cells.min_row; row <= cells.max_row; ++row) {
+            for (size_t column = cells.min_column; column <= cells.max_column; ++column) {
+                cell_entries_[filled[row * columns_ + column]++] = static_cast<uint32_t>(idx);
+            }
+        }
+    }
+}
+
+inline std::vector<size_t> GridIndex::Query(const Rect& area) const {
+    std::vector<size_t> ids;
+    if (entries_.empty() || !bounds_.Intersects(area)) {
+        return ids;
+    }
+
+    const auto cells = GetCells(area);
+    for (size_t row = cells.min_row; row <= cells.max_row; ++row) {
+        for (size_t column = cells.min_column; column <= cells.max_column; ++column) {
+            const size_t cell = row * columns_ + column;
+            for (auto idx = cell_offsets_[cell]; idx < cell_offsets_[cell + 1]; ++idx) {
+                const auto& entry = entries_[cell_entries_[idx]];
+                if (entry.box.Intersects(area)) {
+                    ids.push_back(entry.id);
+                }
+            }
+        }
+    }
+
+    // Rectangles spanning several cells and items with several rectangles are found repeatedly
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    return ids;
+}
+
+inline GridIndex::CellRange GridIndex::GetCells(const Rect& box) const {
+    return { ToColumn(box.min_x), ToRow(box.min_y), ToColumn(box.max_x), ToRow(box.max_y) };
+}
+
+inline size_t GridIndex::ToColumn(double x) const {
+    const double column = std::floor((x - bounds_.min_x) / cell_width_);
+    return static_cast<size_t>(std::clamp(column, 0.0, static_cast<double>(columns_ - 1)));
+}
+
+inline size_t GridIndex::ToRow(double y) const {
+    const double row = std::floor((y - bounds_.min_y) / cell_height_);
+    return static_cast<size_t>(std::clamp(row, 0.0, static_cast<double>(rows_ - 1)));
+}
+
+}  // namespace spatial
@@ -1,5 +1,9 @@
 #include "json.h"
 
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
 #include <iterator>
 
 namespace json {
@@ -19,7 +23,7 @@ std::string LoadLiteral(std::istream& input) {
 }
 
 Node LoadArray(std::istream& input) {
-    std::vector<Node> result;
+    Array result;
 
     for (char c; input >> c && c != ']';) {
         if (c != ',') {
@@ -57,7 +61,7 @@ Node LoadDict(std::istream& input) {
     return Node(std::move(dict));
 }
 
-Node LoadString(std::istream& input) {
+std::string LoadStringValue(std::istream& input) {
     auto it = std::istreambuf_iterator<char>(input);
     auto end = std::istreambuf_iterator<char>();
     std::string s;
@@ -102,7 +106,11 @@ Node LoadString(std::istream& input) {
         ++it;
     }
 
-    return Node(std::move(s));
+    return s;
+}
+
+Node LoadString(std::istream& input) {
+    return Node(LoadStringValue(input));
 }
 
 Node LoadBool(std::istream& input) {
@@ -222,10 +230,366 @@ Node LoadNode(std::istream& input) {
     }
 }
 
+void ParseNode(std::istream& input, Handler& handler);
+
+void ParseArray(std::istream& input, Handler& handler) {
+    handler.StartArray();
+    for (char c; input >> c && c != ']';) {
+        if (c != ',') {
+            input.putback(c);
+        }
+        ParseNode(input, handler);
+    }
+    if (!input) {
+        throw ParsingError("Array parsing error"s);
+    }
+    handler.EndArray();
+}
+
+void ParseDict(std::istream& input, Handler& handler) {
+    handler.StartDict();
+    for (char c; input >> c && c != '}';) {
+        if (c == '"') {
+            handler.Key(LoadStringValue(input));
+            if (input >> c && c == ':') {
+                ParseNode(input, handler);
+            } else {
+                throw ParsingError(": is expected but '"s + c + "' has been found"s);
+            }
+        } else if (c != ',') {
+            throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
+        }
+    }
+    if (!input) {
+        throw ParsingError("Dictionary parsing error"s);
+    }
+    handler.EndDict();
+}
+
+void ParseNode(std::istream& input, Handler& handler) {
+    char c;
+    if (!(input >> c)) {
+        throw ParsingError("Unexpected EOF"s);
+    }
+    switch (c) {
+        case '[':
+            ParseArray(input, handler);
+            break;
+        case '{':
+            ParseDict(input, handler);
+            break;
+        case '"':
+            handler.Value(LoadStringValue(input));
+            break;
+        default:
+            //       ,   Load
+            input.putback(c);
+            handler.Value(LoadNode(input).GetValue());
+            break;
+    }
+}
+
+//    .        
+//    ,   ,   
+// std::from_chars   
+class BufferParser {
+public:
+    BufferParser(std::string_view text, std::pmr::memory_resource* resource)
+        : pos_(text.data())
+        , end_(text.data() + text.size())
+        , resource_(resource) {
+    }
+
+    Node LoadNode() {
+        switch (NextChar("Unexpected EOF"sv)) {
+            case '[':
+                ++pos_;
+                return LoadArray();
+            case '{':
+                ++pos_;
+                return LoadDict();
+            case '"':
+                ++pos_;
+                return Node(ReadString());
+            default:
+                return Node(ReadScalar());
+        }
+    }
+
+    void ParseNode(Handler& handler) {
+        switch (NextChar("Unexpected EOF"sv)) {
+            case '[':
+                ++pos_;
+                ParseArray(handler);
+                break;
+            case '{':
+                ++pos_;
+                ParseDict(handler);
+                break;
+            case '"':
+                ++pos_;
+                handler.Value(ReadString());
+                break;
+            default:
+                handler.Value(ReadScalar());
+                break;
+        }
+    }
+
+private:
+    static constexpr uint64_t ONES = 0x0101010101010101;
+    static constexpr uint64_t HIGH_BITS = 0x8080808080808080;
+    static constexpr uint64_t SPACES = ONES * ' ';
+
+    static uint64_t LoadWord(const char* pos) {
+        uint64_t word;
+        std::memcpy(&word, pos, sizeof(word));
+        return word;
+    }
+
+    //  ,   word   byte (    )
+    static uint64_t HasByte(uint64_t word, char byte) {
+        const uint64_t diff = word ^ (ONES * static_cast<unsigned char>(byte));
+        return (diff - ONES) & ~diff & HIGH_BITS;
+    }
+
+    static bool IsSpace(char c) {
+        return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+    }
+
+    static bool IsDigit(char c) {
+        return c >= '0' && c <= '9';
+    }
+
+    static bool IsAlpha(char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+    }
+
+    //       ,   
+    char NextChar(std::string_view eof_message) {
+        while (pos_ != end_) {
+            //     
+            if (end_ - pos_ >= 8 && LoadWord(pos_) == SPACES) {
+                pos_ += 8;
+                continue;
+            }
+            if (!IsSpace(*pos_)) {
+                return *pos_;
+            }
+            ++pos_;
+        }
+        throw ParsingError(std::string(eof_message));
+    }
+
+    //  ,      
+    const char* FindStringSpecial(const char* pos) const {
+        while (end_ - pos >= 8) {
+            const uint64_t word = LoadWord(pos);
+            if (HasByte(word, '"') | HasByte(word, '\\') | HasByte(word, '\n') | HasByte(word, '\r')) {
+                break;
+            }
+            pos += 8;
+        }
+        while (pos != end_ && *pos != '"' && *pos != '\\' && *pos != '\n' && *pos != '\r') {
+            ++pos;
+        }
+        return pos;
+    }
+
+    //     
+    std::string ReadString() {
+        std::string s;
+        while (true) {
+            const char* special = FindStringSpecial(pos_);
+            s.append(pos_, special);
+            pos_ = special;
+            if (pos_ == end_) {
+                throw ParsingError("String parsing error");
+            }
+
+            const char ch = *pos_++;
+            if (ch == '"') {
+                return s;
+            }
+            if (ch != '\\') {
+                throw ParsingError("Unexpected end of line"s);
+            }
+            if (pos_ == end_) {
+                throw ParsingError("String parsing error");
+            }
+            const char escaped_char = *pos_++;
+            switch (escaped_char) {
+                case 'n':
+                    s.push_back('\n');
+                    break;
+                case 't':
+                    s.push_back('\t');
+                    break;
+                case 'r':
+                    s.push_back('\r');
+                    break;
+                case '"':
+                    s.push_back('"');
+                    break;
+                case '\\':
+                    s.push_back('\\');
+                    break;
+                default:
+                    throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
+            }
+        }
+    }
+
+    Node::Value ReadScalar() {
+        if (*pos_ == 't' || *pos_ == 'f' || *pos_ == 'n') {
+            return ReadLiteral();
+        }
+        return ReadNumber();
+    }
+
+    Node::Value ReadLiteral() {
+        const char* begin = pos_;
+        while (pos_ != end_ && IsAlpha(*pos_)) {
+            ++pos_;
+        }
+        const std::string_view literal(begin, pos_ - begin);
+        if (literal == "true"sv) {
+            return true;
+        } else if (literal == "false"sv) {
+            return false;
+        } else if (literal == "null"sv) {
+            return nullptr;
+        }
+        const std::string type = *begin == 'n' ? "null"s : "bool"s;
+        throw ParsingError("Failed to parse '"s + std::string(literal) + "' as "s + type);
+    }
+
+    void ReadDigits() {
+        if (pos_ == end_ || !IsDigit(*pos_)) {
+            throw ParsingError("A digit is expected"s);
+        }
+        while (pos_ != end_ && IsDigit(*pos_)) {
+            ++pos_;
+        }
+    }
+
+    //    ,   LoadNumber
+    Node::Value ReadNumber() {
+        const char* begin = pos_;
+        if (*pos_ == '-') {
+            ++pos_;
+        }
+        if (pos_ != end_ && *pos_ == '0') {
+            ++pos_;
+        } else {
+            ReadDigits();
+        }
+
+        bool is_int = true;
+        if (pos_ != end_ && *pos_ == '.') {
+            ++pos_;
+            ReadDigits();
+            is_int = false;
+        }
+        if (pos_ != end_ && (*pos_ == 'e' || *pos_ == 'E')) {
+            ++pos_;
+            if (pos_ != end_ && (*pos_ == '+' || *pos_ == '-')) {
+                ++pos_;
+            }
+            ReadDigits();
+            is_int = false;
+        }
+
+        if (is_int) {
+            int value = 0;
+            if (const auto [ptr, ec] = std::from_chars(begin, pos_, value); ec == std::errc{} && ptr == pos_) {
+                return value;
+            }
+            //   int    double
+        }
+        double value = 0;
+        if (const auto [ptr, ec] = std::from_chars(begin, pos_, value); ec != std::errc{} || ptr != pos_) {
+            throw ParsingError("Failed to convert "s + std::string(begin, pos_) + " to number"s);
+        }
+        return value;
+    }
+
+    Node LoadArray() {
+        Array result(resource_);
+        while (NextChar("Array parsing error"sv) != ']') {
+            if (*pos_ == ',') {
+                ++pos_;
+            }
+            result.push_back(LoadNode());
+        }
+        ++pos_;
+        return Node(std::move(result));
+    }
+
+    Node LoadDict() {
+        Dict dict(resource_);
+        for (char c; (c = NextChar("Dictionary parsing error"sv)) != '}';) {
+            ++pos_;
+            if (c == '"') {
+                std::string key = ReadString();
+                if (NextChar("Dictionary parsing error"sv) != ':') {
+                    throw ParsingError(": is expected but '"s + *pos_ + "' has been found"s);
+                }
+                ++pos_;
+                if (dict.find(key) != dict.end()) {
+                    throw ParsingError("Duplicate key '"s + key + "' have been found");
+                }
+                dict.emplace(std::move(key), LoadNode());
+            } else if (c != ',') {
+                throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
+            }
+        }
+        ++pos_;
+        return Node(std::move(dict));
+    }
+
+    void ParseArray(Handler& handler) {
+        handler.StartArray();
+        while (NextChar("Array parsing error"sv) != ']') {
+            if (*pos_ == ',') {
+                ++pos_;
+            }
+            ParseNode(handler);
+        }
+        ++pos_;
+        handler.EndArray();
+    }
+
+    void ParseDict(Handler& handler) {
+        handler.StartDict();
+        for (char c; (c = NextChar("Dictionary parsing error"sv)) != '}';) {
+            ++pos_;
+            if (c == '"') {
+                handler.Key(ReadString());
+                if (NextChar("Dictionary parsing error"sv) != ':') {
+                    throw ParsingError(": is expected but '"s + *pos_ + "' has been found"s);
+                }
+                ++pos_;
+                ParseNode(handler);
+            } else if (c != ',') {
+                throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
+            }
+        }
+        ++pos_;
+        handler.EndDict();
+    }
+
+    const char* pos_;
+    const char* end_;
+    std::pmr::memory_resource* resource_;
+};
+
 struct PrintContext {
     std::ostream& out;
     int indent_step = 4;
     int indent = 0;
+    //    ,    
+    bool is_compact = false;
 
     void PrintIndent() const {
         for (int i = 0; i < indent; ++i) {
@@ -233,8 +597,14 @@ struct PrintContext {
         }
     }
 
+    void PrintLineBreak() const {
+        if (!is_compact) {
+            out.put('\n');
+        }
+    }
+
     PrintContext Indented() const {
-        return {out, indent_step, indent_step + indent};
+        return {out, indent_step, indent_step + indent, is_compact};
     }
 };
 
@@ -245,38 +615,16 @@ void PrintValue(const Value& value, const PrintContext& ctx) {
     ctx.out << value;
 }
 
-void PrintString(const std::string& value, std::ostream& out) {
-    out.put('"');
-    for (const char c : value) {
-        switch (c) {
-            case '\r':
-                out << "\\r"sv;
-                break;
-            case '\n':
-                out << "\\n"sv;
-                break;
-            case '\t':
-                out << "\\t"sv;
-                break;
-            case '"':
-                //  "  \   \"  \\, 
-                [[fallthrough]];
-            case '\\':
-                out.put('\\');
-                [[fallthrough]];
-            default:
-                out.put(c);
-                break;
-        }
-    }
-    out.put('"');
-}
-
 template <>
 void PrintValue<std::string>(const std::string& value, const PrintContext& ctx) {
     PrintString(value, ctx.out);
 }
 
+template <>
+void PrintValue<RawString>(const RawString& value, const PrintContext& ctx) {
+    ctx.out << value.text;
+}
+
 template <>
 void PrintValue<std::nullptr_t>(const std::nullptr_t&, const PrintContext& ctx) {
     ctx.out << "null"sv;
@@ -294,19 +642,21 @@ void PrintValue<bool>(const bool& value, const PrintContext& ctx) {
 template <>
 void PrintValue<Array>(const Array& nodes, const PrintContext& ctx) {
     std::ostream& out = ctx.out;
-    out << "[\n"sv;
+    out.put('[');
+    ctx.PrintLineBreak();
     bool first = true;
     auto inner_ctx = ctx.Indented();
     for (const Node& node : nodes) {
         if (first) {
             first = false;
         } else {
-            out << ",\n"sv;
+            out.put(',');
+            ctx.PrintLineBreak();
         }
         inner_ctx.PrintIndent();
         PrintNode(node, inner_ctx);
     }
-    out.put('\n');
+    ctx.PrintLineBreak();
     ctx.PrintIndent();
     out.put(']');
 }
@@ -314,21 +664,23 @@ void PrintValue<Array>(const Array& nodes, const PrintContext& ctx) {
 template <>
 void PrintValue<Dict>(const Dict& nodes, const PrintContext& ctx) {
     std::ostream& out = ctx.out;
-    out << "{\n"sv;
+    out.put('{');
+    ctx.PrintLineBreak();
     bool first = true;
     auto inner_ctx = ctx.Indented();
     for (const auto& [key, node] : nodes) {
         if (first) {
             first = false;
         } else {
-            out << ",\n"sv;
+            out.put(',');
+            ctx.PrintLineBreak();
         }
         inner_ctx.PrintIndent();
         PrintString(key, ctx.out);
-        out << ": "sv;
+        out << (ctx.is_compact ? ":"sv : ": "sv);
         PrintNode(node, inner_ctx);
     }
-    out.put('\n');
+    ctx.PrintLineBreak();
     ctx.PrintIndent();
     out.put('}');
 }
@@ -347,8 +699,94 @@ Document Load(std::istream& input) {
     return Document{LoadNode(input)};
 }
 
+void Parse(std::istream& input, Handler& handler) {
+    ParseNode(input, handler);
+}
+
+Document Load(std::string_view text) {
+    //      ,   
+    auto arena = std::make_shared<std::pmr::monotonic_buffer_resource>(
+        std::max<size_t>(text.size(), 1));
+    Node root = BufferParser(text, arena.get()).LoadNode();
+    return Document(std::move(root), std::move(arena));
+}
+
+void Parse(std::string_view text, Handler& handler) {
+    BufferParser(text, std::pmr::get_default_resource()).ParseNode(handler);
+}
+
 void Print(const Document& doc, std::ostream& output) {
     PrintNode(doc.GetRoot(), PrintContext{output});
 }
 
+void PrintCompact(const Document& doc, std::ostream& output) {
+    PrintNode(doc.GetRoot(), PrintContext{output, 0, 0, true});
+}
+
+ArrayPrinter::ArrayPrinter(std::ostream& output)
+    : output_(output) {
+    output_ << "[\n"sv;
+}
+
+void PrintArrayElement(const Node& node, std::ostream& output) {
+    const auto inner_ctx = PrintContext{output}.Indented();
+    inner_ctx.PrintIndent();
+    PrintNode(node, inner_ctx);
+}
+
+void ArrayPrinter::Print(const Node& node) {
+    StartElement();
+    PrintArrayElement(node, output_);
+}
+
+void ArrayPrinter::PrintPrinted(std::string_view element) {
+    StartElement();
+    output_ << element;
+}
+
+void ArrayPrinter::StartElement() {
+    if (is_finished_) {
+        throw std::logic_error("Array printing is finished"s);
+    }
+    if (!is_empty_) {
+        output_ << ",\n"sv;
+    }
+    is_empty_ = false;
+}
+
+void ArrayPrinter::Finish() {
+    if (is_finished_) {
+        throw std::logic_error("Array printing is finished"s);
+    }
+    is_finished_ = true;
+    output_ << "\n]"sv;
+}
+
+void PrintString(std::string_view value, std::ostream& out) {
+    out.put('"');
+    for (const char c : value) {
+        switch (c) {
+            case '\r':
+                out << "\\r"sv;
+                break;
+            case '\n':
+                out << "\\n"sv;
+                break;
+            case '\t':
+                out << "\\t"sv;
+                break;
+            case '"':
+                //  "  \   \"  \\, 
+                [[fallthrough]];
+            case '\\':
+                out.put('\\');
+                [[fallthrough]];
+            default:
+                out.put(c);
+                break;
+        }
+    }
+    out.put('"');
+}
+
 }  // namespace json
\ No newline at end of file
@@ -2,24 +2,39 @@
 
 #include <iostream>
 #include <map>
+#include <memory>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
 
 namespace json {
 
 class Node;
-using Dict = std::map<std::string, Node>;
-using Array = std::vector<Node>;
+//    :      .
+//        
+using Dict = std::pmr::map<std::string, Node>;
+using Array = std::pmr::vector<Node>;
 
 class ParsingError : public std::runtime_error {
 public:
     using runtime_error::runtime_error;
 };
 
+// ,     JSON   .   ,
+//  ,      
+struct RawString {
+    std::string_view text;
+};
+
+inline bool operator==(const RawString& lhs, const RawString& rhs) {
+    return lhs.text == rhs.text;
+}
+
 class Node final {
 public:
-    using Value = std::variant<std::nullptr_t, Array, Dict, bool, int, double, std::string>;
+    using Value = std::variant<std::nullptr_t, Array, Dict, bool, int, double, std::string, RawString>;
 
     Node() = default;
 
@@ -48,6 +63,9 @@ public:
     Node(bool val)
         : value_(val) {
     }
+    Node(RawString val)
+        : value_(val) {
+    }
 
     bool IsInt() const {
         return std::holds_alternative<int>(value_);
@@ -145,15 +163,24 @@ inline bool operator!=(const Node& lhs, const Node& rhs) {
 class Document {
 public:
     Document() = default;
-    explicit Document(Node root)
+    explicit Document(Node&& root)
         : root_(std::move(root)) {
     }
+    //  root   arena,      .
+    //     -  std::string:    
+    //  -    
+    Document(Node&& root, std::shared_ptr<std::pmr::memory_resource> arena)
+        : arena_(std::move(arena))
+        , root_(std::move(root)) {
+    }
 
     const Node& GetRoot() const {
         return root_;
     }
 
 private:
+    //   root_,    
+    std::shared_ptr<std::pmr::memory_resource> arena_;
     Node root_; //   (std::nullptr_t, Array, Dict, bool, int, double, std::string)
 };
 
@@ -166,7 +193,59 @@ inline bool operator!=(const Document& lhs, const Document& rhs) {
 }
 
 Document Load(std::istream& input);
+//     ,   ,   Load(std::istream&).
+//        ,  - 
+Document Load(std::string_view text);
+
+//    .       
+class Handler {
+public:
+    virtual void StartDict() = 0;
+    virtual void Key(std::string key) = 0;
+    virtual void EndDict() = 0;
+    virtual void StartArray() = 0;
+    virtual void EndArray() = 0;
+    virtual void Value(Node::Value value) = 0;
+
+protected:
+    ~Handler() = default;
+};
+
+//  JSON  input,   :     handler.
+//    Load     
+void Parse(std::istream& input, Handler& handler);
+void Parse(std::string_view text, Handler& handler);
 
 void Print(const Document& doc, std::ostream& output);
+//       .     ,
+//      '\n'
+void PrintCompact(const Document& doc, std::ostream& output);
+
+//    ,    ,  Print
+void PrintString(std::string_view value, std::ostream& output);
+
+//  node  ,  Print   :    
+void PrintArrayElement(const Node& node, std::ostream& output);
+
+//     ,     .
+//    Print ,   -     
+class ArrayPrinter {
+public:
+    //   
+    explicit ArrayPrinter(std::ostream& output);
+
+    void Print(const Node& node);
+    //  ,   PrintArrayElement
+    void PrintPrinted(std::string_view element);
+    //   ,     
+    void Finish();
+
+private:
+    void StartElement();
+
+    std::ostream& output_;
+    bool is_empty_ = true;
+    bool is_finished_ = false;
+};
 
 }  // namespace json
\ No newline at end of file
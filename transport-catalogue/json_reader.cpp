@@ -1,5 +1,11 @@
 #include "json_reader.h"
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
 #include <sstream>
+#include <stdexcept>
+#include <thread>
 
 namespace transport::reader {
 
@@ -8,20 +14,160 @@ JSONReader::JSONReader(Catalogue& catalogue)
 {
 }
 
-void JSONReader::AddStopsToDataBase(json::Array& data, std::map<std::string, json::Dict>& distances) {
-	using namespace std::string_literals;
+//     .  base_requests   
+//  :  ,    ,   ,
+//   .      
+class JSONReader::DocumentHandler final : public json::Handler {
+public:
+	explicit DocumentHandler(JSONReader& reader)
+		: reader_(reader) {
+	}
 
-	for (const json::Node& node : data) {
-		json::Dict req_map = node.AsDict();
-		std::string req_type = req_map.at("type"s).AsString();
+	void StartDict() override {
+		StartContainer(false);
+		if (subtree_) {
+			subtree_->StartDict();
+		}
+		++depth_;
+	}
+
+	void EndDict() override {
+		--depth_;
+		if (subtree_) {
+			subtree_->EndDict();
+		}
+		EndContainer();
+	}
+
+	void StartArray() override {
+		StartContainer(true);
+		if (subtree_) {
+			subtree_->StartArray();
+		}
+		++depth_;
+	}
+
+	void EndArray() override {
+		--depth_;
+		if (subtree_) {
+			subtree_->EndArray();
+		}
+		EndContainer();
+	}
+
+	void Key(std::string key) override {
+		if (subtree_) {
+			subtree_->Key(std::move(key));
+		}
+		else {
+			section_ = std::move(key);
+		}
+	}
+
+	void Value(json::Node::Value value) override {
+		if (subtree_) {
+			subtree_->Value(std::move(value));
+		}
+		else if (depth_ == 0) {
+			throw json::ParsingError("Input document should be a dict");
+		}
+		else {
+			AddNode(json::Node(std::move(value)));
+		}
+	}
 
+	json::Dict ExtractSections() {
+		return std::move(sections_);
+	}
+
+private:
+	static constexpr size_t SECTION_DEPTH = 1;
+	static constexpr size_t BASE_REQUEST_DEPTH = 2;
+
+	void StartContainer(bool is_array) {
+		using namespace std::string_literals;
+
+		if (subtree_) {
+			return;
+		}
+		if (depth_ == 0) {
+			if (is_array) {
+				throw json::ParsingError("Input document should be a dict");
+			}
+			return;
+		}
+		if (depth_ == SECTION_DEPTH && is_array && section_ == "base_requests"s) {
+			in_base_requests_ = true;
+			return;
+		}
+		//      base_requests
+		subtree_.emplace();
+		subtree_depth_ = depth_;
+	}
+
+	void EndContainer() {
+		if (subtree_ && depth_ == subtree_depth_) {
+			json::Node node = subtree_->Build();
+			subtree_.reset();
+			AddNode(std::move(node));
+		}
+		else if (!subtree_ && in_base_requests_ && depth_ == SECTION_DEPTH) {
+			in_base_requests_ = false;
+			reader_.AddDistancesToDataBase(distances_);
+			reader_.AddRoutesToDataBase(buses_);
+			distances_.clear();
+			buses_.clear();
+		}
+	}
+
+	void AddNode(json::Node node) {
+		using namespace std::string_literals;
+
+		if (depth_ == SECTION_DEPTH) {
+			sections_[section_] = std::move(node);
+			return;
+		}
+
+		const std::string& req_type = node.AsDict().at("type"s).AsString();
 		if (req_type == "Stop"s) {
-			std::string name = req_map.at("name"s).AsString();
-			double latitude = req_map.at("latitude"s).AsDouble();
-			double longitude = req_map.at("longitude"s).AsDouble();
-			distances[name] = req_map.at("road_distances"s).AsDict();
+			reader_.AddStopToDataBase(node.AsDict(), distances_);
+		}
+		else if (req_type == "Bus"s) {
+			buses_.push_back(std::move(node));
+		}
+	}
 
-			catalogue_.AddStop({ name, latitude, longitude });
+	JSONReader& reader_;
+	json::Dict sections_;
+	std::string section_;
+	size_t depth_ = 0;
+	bool in_base_requests_ = false;
+	// ,   ,  ,    
+	std::optional<json::Builder> subtree_;
+	size_t subtree_depth_ = 0;
+	std::map<std::string, json::Dict> distances_;
+	json::Array buses_;
+};
+
+void JSONReader::AddStopToDataBase(const json::Dict& req_map, std::map<std::string, json::Dict>& distances) {
+	using namespace std::string_literals;
+
+	std::string name = req_map.at("name"s).AsString();
+	double latitude = req_map.at("latitude"s).AsDouble();
+	double longitude = req_map.at("longitude"s).AsDouble();
+	distances[name] = req_map.at("road_distances"s).AsDict();
+
+	catalogue_.AddStop({ name, latitude, longitude });
+}
+
+void JSONReader::AddStopsToDataBase(const json::Array& data, std::map<std::string, json::Dict>& distances) {
+	using namespace std::string_literals;
+
+	for (const json::Node& node : data) {
+		const json::Dict& req_map = node.AsDict();
+
+		if (req_map.at("type"s).AsString() == "Stop"s) {
+			AddStopToDataBase(req_map, distances);
 		}
 	}
 }
@@ -37,43 +183,172 @@ void JSONReader::AddDistancesToDataBase(std::map<std::string, json::Dict>& dista
 	}
 }
 
-void JSONReader::AddRoutesToDataBase(json::Array& data) {
+void JSONReader::AddRoutesToDataBase(const json::Array& data) {
 	using namespace std::string_literals;
 
 	for (const json::Node& node : data) {
-		json::Dict req_map = node.AsDict();
+		const json::Dict& req_map = node.AsDict();
 		std::string req_type = req_map.at("type"s).AsString();
 
 		if (req_type == "Bus"s) {
-			std::string name = req_map.at("name"s).AsString();
-			json::Array stops = req_map.at("stops"s).AsArray();
-			bool is_roundtrip = req_map.at("is_roundtrip").AsBool();
+			AddRouteToDataBase(req_map);
+		}
+	}
+}
 
-			std::vector<detail::Stop*> route;
-			std::vector<detail::Stop*> final_route;
+//    -      ,  
+//       
+constexpr double MAX_SCHEDULE_TIME = 2 * 24 * 60;
+//         
+constexpr size_t MAX_TRIP_COUNT = 10000;
+
+double ReadScheduleTime(const json::Node& node) {
+	const double time = node.AsDouble();
+	//    NaN
+	if (!(time >= 0 && time <= MAX_SCHEDULE_TIME)) {
+		throw std::invalid_argument("Schedule time is out of range");
+	}
+	return time;
+}
 
-			for (const json::Node& stop : stops) {
-				route.push_back(catalogue_.FindStop(stop.AsString()));
+//  :          .
+// "departures" -  ,  "first_departure", "last_departure"  "interval" -
+//    
+std::vector<double> ReadDepartures(const json::Dict& schedule) {
+	using namespace std::string_literals;
+
+	std::vector<double> departures;
+	if (const auto it = schedule.find("departures"s); it != schedule.end()) {
+		const json::Array& times = it->second.AsArray();
+		if (times.size() > MAX_TRIP_COUNT) {
+			throw std::invalid_argument("Schedule has too many departures");
+		}
+		for (const json::Node& departure : times) {
+			departures.push_back(ReadScheduleTime(departure));
+		}
+	}
+	else {
+		const double first = ReadScheduleTime(schedule.at("first_departure"s));
+		const double last = ReadScheduleTime(schedule.at("last_departure"s));
+		const double interval = schedule.at("interval"s).AsDouble();
+		if (!(interval > 0)) {
+			throw std::invalid_argument("Schedule interval should be positive");
+		}
+		if (first > last) {
+			throw std::invalid_argument("Schedule first_departure should not be later than last_departure");
+		}
+		//     ,     
+		for (size_t idx = 0; first + idx * interval <= last; ++idx) {
+			if (departures.size() == MAX_TRIP_COUNT) {
+				throw std::invalid_argument("Schedule has too many departures");
 			}
+			departures.push_back(first + idx * interval);
+		}
+	}
+	std::sort(departures.begin(), departures.end());
+	return departures;
+}
+
+void JSONReader::AddRouteToDataBase(const json::Dict& req_map) {
+	using namespace std::string_literals;
 
-			//   
-			final_route.push_back(route.front());
-			if (route.front() != route.back()) {
-				final_route.push_back(route.back());
+	std::string name = req_map.at("name"s).AsString();
+	json::Array stops = req_map.at("stops"s).AsArray();
+	bool is_roundtrip = req_map.at("is_roundtrip").AsBool();
+
+	std::vector<detail::Stop*> route;
+	std::vector<detail::Stop*> final_route;
+
+	for (const json::Node& stop : stops) {
+		route.push_back(catalogue_.FindStop(stop.AsString()));
+	}
+
+	//   
+	final_route.push_back(route.front());
+	if (route.front() != route.back()) {
+		final_route.push_back(route.back());
+	}
+
+	//    "stop1 - stop2 - ... stopN" 
+	//   "stop1 > stop2 > ... > stopN-1 > stopN > stopN-1 > ... > stop2 > stop1"
+	if (!is_roundtrip) {
+		route.insert(route.end(), route.rbegin() + 1, route.rend());
+	}
+	detail::bus::Bus bus{ name, route, final_route, is_roundtrip };
+	if (const auto it = req_map.find("schedule"s); it != req_map.end()) {
+		bus.departures = ReadDepartures(it->second.AsDict());
+	}
+	catalogue_.AddBus(std::move(bus));
+}
+
+void JSONReader::ApplyUpdates(const json::Array& data) {
+	using namespace std::string_literals;
+
+	//    base_requests,       - 
+	const auto check_stop = [this](const std::string& name) {
+		if (catalogue_.FindStop(name) == nullptr) {
+			throw std::invalid_argument("Unknown stop "s + name);
+		}
+	};
+
+	//    :       
+	std::map<std::string, json::Dict> distances;
+	for (const json::Node& node : data) {
+		const json::Dict& req_map = node.AsDict();
+		if (req_map.at("type"s).AsString() != "Stop"s) {
+			continue;
+		}
+		const std::string& name = req_map.at("name"s).AsString();
+		if (catalogue_.FindStop(name) == nullptr) {
+			AddStopToDataBase(req_map, distances);
+		}
+		else if (const auto it = req_map.find("road_distances"s); it != req_map.end()) {
+			//       
+			for (const auto& [stop_b, distance] : it->second.AsDict()) {
+				distances[name][stop_b] = distance;
 			}
+		}
+	}
+	for (const auto& [stop_a, map_distances] : distances) {
+		for (const auto& [stop_b, distance] : map_distances) {
+			check_stop(stop_b);
+		}
+	}
+	AddDistancesToDataBase(distances);
+
+	for (const json::Node& node : data) {
+		const json::Dict& req_map = node.AsDict();
+		const std::string& req_type = req_map.at("type"s).AsString();
+		if (req_type != "Bus"s && req_type != "RemoveBus"s) {
+			continue;
+		}
 
-			//    "stop1 - stop2 - ... stopN" 
-			//   "stop1 > stop2 > ... > stopN-1 > stopN > stopN-1 > ... > stop2 > stop1"
-			if (!is_roundtrip) {
-				route.insert(route.end(), route.rbegin() + 1, route.rend());
+		const std::string& name = req_map.at("name"s).AsString();
+		if (req_type == "Bus"s) {
+			const auto& stops = req_map.at("stops"s).AsArray();
+			if (stops.empty()) {
+				throw std::invalid_argument("Bus "s + name + " has no stops"s);
+			}
+			for (const json::Node& stop : stops) {
+				check_stop(stop.AsString());
 			}
-			catalogue_.AddBus({ name, route, final_route, is_roundtrip });		
+		}
+
+		//    
+		if (auto* bus = catalogue_.FindBus(name)) {
+			catalogue_.RemoveBus(bus);
+		}
+		else if (req_type == "RemoveBus"s) {
+			throw std::invalid_argument("Unknown bus "s + name);
+		}
+		if (req_type == "Bus"s) {
+			AddRouteToDataBase(req_map);
 		}
 	}
 }
 
 //     
-void JSONReader::FillDataBase(json::Array& data) {
+void JSONReader::FillDataBase(const json::Array& data) {
 	std::map<std::string, json::Dict> distances;
 
 	//     
@@ -84,6 +359,18 @@ void JSONReader::FillDataBase(json::Array& data) {
 	AddRoutesToDataBase(data);
 }
 
+json::Dict JSONReader::ReadDocument(std::istream& input) {
+	DocumentHandler handler(*this);
+	json::Parse(input, handler);
+	return handler.ExtractSections();
+}
+
+json::Dict JSONReader::ReadDocument(std::string_view text) {
+	DocumentHandler handler(*this);
+	json::Parse(text, handler);
+	return handler.ExtractSections();
+}
+
 svg::Point ReadPoint(const json::Array& arr) {
 	return { arr[0].AsDouble(), arr[1].AsDouble() };
 }
@@ -138,6 +425,33 @@ renderer::RenderSettings JSONReader::ReadRenderSettings(const json::Dict& data)
 	return render_settings;
 }
 
+graph::RouterMode ReadRouterMode(const std::string& mode) {
+	using namespace std::string_literals;
+
+	if (mode == "all_pairs"s) {
+		return graph::RouterMode::ALL_PAIRS;
+	}
+	else if (mode == "on_demand"s) {
+		return graph::RouterMode::ON_DEMAND;
+	}
+	else if (mode == "contraction_hierarchy"s) {
+		return graph::RouterMode::CONTRACTION_HIERARCHY;
+	}
+	throw std::invalid_argument("Unknown router mode: "s + mode);
+}
+
+router::GraphModel ReadGraphModel(const std::string& model) {
+	using namespace std::string_literals;
+
+	if (model == "span_edges"s) {
+		return router::GraphModel::SPAN_EDGES;
+	}
+	else if (model == "ride_chains"s) {
+		return router::GraphModel::RIDE_CHAINS;
+	}
+	throw std::invalid_argument("Unknown graph model: "s + model);
+}
+
 //  bus_wait_time  bus_velocity
 router::RoutingSettings JSONReader::ReadRoutingSettings(const json::Dict& data) {
 	using namespace std::string_literals;
@@ -147,9 +461,61 @@ router::RoutingSettings JSONReader::ReadRoutingSettings(const json::Dict& data)
 	routing_settings.bus_wait_time = data.at("bus_wait_time"s).AsInt();
 	routing_settings.bus_velocity = data.at("bus_velocity"s).AsDouble();
 
+	//    :
+	// "all_pairs" ( ), "on_demand"  "contraction_hierarchy"
+	if (const auto it = data.find("router_mode"s); it != data.end()) {
+		routing_settings.router_mode = ReadRouterMode(it->second.AsString());
+	}
+	//   : "span_edges" ( )  "ride_chains"
+	if (const auto it = data.find("graph_model"s); it != data.end()) {
+		routing_settings.graph_model = ReadGraphModel(it->second.AsString());
+	}
+	//       
+	if (const auto it = data.find("thread_count"s); it != data.end()) {
+		routing_settings.thread_count = static_cast<size_t>(std::max(it->second.AsInt(), 1));
+	}
+
 	return routing_settings;
 }
 
+serialization::SerializationSettings JSONReader::ReadSerializationSettings(const json::Dict& data) {
+	using namespace std::string_literals;
+
+	return { std::filesystem::path(data.at("file"s).AsString()) };
+}
+
+StatSettings JSONReader::ReadStatSettings(const json::Dict& data) {
+	using namespace std::string_literals;
+
+	StatSettings stat_settings;
+
+	//     
+	if (const auto it = data.find("thread_count"s); it != data.end()) {
+		stat_settings.thread_count = static_cast<size_t>(std::max(it->second.AsInt(), 1));
+	}
+
+	return stat_settings;
+}
+
+server::ServerSettings JSONReader::ReadServerSettings(const json::Dict& data) {
+	using namespace std::string_literals;
+
+	server::ServerSettings server_settings;
+
+	if (const auto it = data.find("unix_socket"s); it != data.end()) {
+		server_settings.unix_socket = it->second.AsString();
+		return server_settings;
+	}
+
+	const int port = data.at("port"s).AsInt();
+	if (port <= 0 || port > 65535) {
+		throw std::invalid_argument("Invalid server port");
+	}
+	server_settings.port = static_cast<uint16_t>(port);
+
+	return server_settings;
+}
+
 void JSONReader::PrintStops(const RequestHandler& handler, std::string& name,
 	json::Builder& builder) const {
 	using namespace std::string_literals;
@@ -185,10 +551,84 @@ void JSONReader::PrintBuses(const RequestHandler& handler, std::string& name,
 			.Key("unique_stop_count").Value(static_cast<int>(info->unique_stops));
 }
 
-void JSONReader::PrintMap(const RequestHandler& handler, json::Builder& builder) const {
+//  "tile"  "bbox"   ,   ,   .
+// "tile": {"zoom", "x", "y"} -      2^zoom    ,
+// "bbox": [min_x, min_y, max_x, max_y] -    
+void JSONReader::PrintMap(const RequestHandler& handler, const json::Dict& map_req,
+	json::Builder& builder) const {
 	using namespace std::string_literals;
 
-	builder.Key("map"s).Value(handler.RenderMap());
+	if (const auto it = map_req.find("tile"s); it != map_req.end()) {
+		const auto& tile = it->second.AsDict();
+		const auto area = handler.GetMapTileArea(tile.at("zoom"s).AsInt(), tile.at("x"s).AsInt(), tile.at("y"s).AsInt());
+		if (!area.has_value()) {
+			builder.Key("error_message"s).Value("invalid tile"s);
+			return;
+		}
+		builder.Key("map"s).Value(handler.RenderMapArea(*area));
+		return;
+	}
+
+	if (const auto it = map_req.find("bbox"s); it != map_req.end()) {
+		const auto& bbox = it->second.AsArray();
+		if (bbox.size() != 4) {
+			builder.Key("error_message"s).Value("invalid bbox"s);
+			return;
+		}
+		const spatial::Rect area{ bbox[0].AsDouble(), bbox[1].AsDouble(), bbox[2].AsDouble(), bbox[3].AsDouble() };
+		//     NaN
+		if (!(area.min_x <= area.max_x && area.min_y <= area.max_y)) {
+			builder.Key("error_message"s).Value("invalid bbox"s);
+			return;
+		}
+		builder.Key("map"s).Value(handler.RenderMapArea(area));
+		return;
+	}
+
+	//      ,     
+	builder.Key("map"s).Value(json::RawString{ handler.RenderMapJson() });
+}
+
+//     "latitude", "longitude": "count" 
+// /    "radius" 
+void JSONReader::PrintNearby(const RequestHandler& handler, const json::Dict& map_req,
+	json::Builder& builder) const {
+	using namespace std::string_literals;
+
+	const geo::Coordinates point{ map_req.at("latitude"s).AsDouble(), map_req.at("longitude"s).AsDouble() };
+
+	std::optional<size_t> count;
+	if (const auto it = map_req.find("count"s); it != map_req.end()) {
+		if (it->second.AsInt() < 0) {
+			builder.Key("error_message"s).Value("invalid count"s);
+			return;
+		}
+		count = static_cast<size_t>(it->second.AsInt());
+	}
+
+	std::optional<double> radius;
+	if (const auto it = map_req.find("radius"s); it != map_req.end()) {
+		//     NaN
+		if (!(it->second.AsDouble() >= 0)) {
+			builder.Key("error_message"s).Value("invalid radius"s);
+			return;
+		}
+		radius = it->second.AsDouble();
+	}
+
+	if (!count.has_value() && !radius.has_value()) {
+		builder.Key("error_message"s).Value("count or radius expected"s);
+		return;
+	}
+
+	builder.Key("stops"s).StartArray();
+	for (const auto& [stop, distance] : handler.FindNearbyStops(point, count, radius)) {
+		builder.StartDict()
+			.Key("name"s).Value(stop->name)
+			.Key("distance"s).Value(distance)
+			.EndDict();
+	}
+	builder.EndArray();
 }
 
 void BuildRouteItem(json::Builder& builder, const transport::router::RouteInfo::BusItem& item) {
@@ -240,42 +680,286 @@ void JSONReader::PrintRoute(const RequestHandler& handler, std::string& from,
 	builder.EndArray();
 }
 
-void JSONReader::ProcessQueries(json::Array& data, RequestHandler& handler, std::ostream& out) const {
+//       "from"    "to":  
+//    "from", null   
+void JSONReader::PrintRouteMatrix(const RequestHandler& handler, const json::Dict& map_req,
+	json::Builder& builder) const {
+	using namespace std::string_literals;
+
+	const auto read_names = [](const json::Array& stops) {
+		std::vector<std::string_view> names;
+		names.reserve(stops.size());
+		for (const auto& stop : stops) {
+			names.push_back(stop.AsString());
+		}
+		return names;
+	};
+
+	const auto matrix = handler.ComputeRouteMatrix(read_names(map_req.at("from"s).AsArray()),
+		read_names(map_req.at("to"s).AsArray()));
+	if (!matrix.has_value()) {
+		builder.Key("error_message"s).Value("not found"s);
+		return;
+	}
+
+	builder.Key("total_times"s).StartArray();
+	for (size_t source_idx = 0; source_idx < matrix->source_count; ++source_idx) {
+		builder.StartArray();
+		for (size_t target_idx = 0; target_idx < matrix->target_count; ++target_idx) {
+			const auto& total_time = matrix->total_times[source_idx * matrix->target_count + target_idx];
+			if (total_time.has_value()) {
+				builder.Value(*total_time);
+			}
+			else {
+				builder.Value(nullptr);
+			}
+		}
+		builder.EndArray();
+	}
+	builder.EndArray();
+}
+
+// ,    "from"    "max_time" ,    .
+//  "render": true    "map" -     
+void JSONReader::PrintIsochrone(const RequestHandler& handler, const json::Dict& map_req,
+	json::Builder& builder) const {
+	using namespace std::string_literals;
+
+	const double max_time = map_req.at("max_time"s).AsDouble();
+	//     NaN
+	if (!(max_time >= 0)) {
+		builder.Key("error_message"s).Value("invalid max_time"s);
+		return;
+	}
+
+	const auto stop_times = handler.FindReachableStops(map_req.at("from"s).AsString(), max_time);
+	if (!stop_times.has_value()) {
+		builder.Key("error_message"s).Value("not found"s);
+		return;
+	}
+
+	builder.Key("stops"s).StartArray();
+	for (const auto& [stop, time] : *stop_times) {
+		builder.StartDict()
+			.Key("name"s).Value(stop->name)
+			.Key("time"s).Value(time)
+			.EndDict();
+	}
+	builder.EndArray();
+
+	if (const auto it = map_req.find("render"s); it != map_req.end() && it->second.AsBool()) {
+		builder.Key("map"s).Value(handler.RenderIsochrone(*stop_times, max_time));
+	}
+}
+
+//       "departure_time"   .
+//   ,    ,      
+void JSONReader::PrintJourney(const RequestHandler& handler, const json::Dict& map_req,
+	json::Builder& builder) const {
+	using namespace std::string_literals;
+
+	const auto journey = handler.FindJourney(map_req.at("from"s).AsString(), map_req.at("to"s).AsString(),
+		map_req.at("departure_time"s).AsDouble());
+	if (!journey.has_value()) {
+		builder.Key("error_message"s).Value("not found"s);
+		return;
+	}
+
+	builder
+		.Key("departure_time"s).Value(journey->departure_time)
+		.Key("arrival_time"s).Value(journey->arrival_time)
+		.Key("total_time"s).Value(journey->arrival_time - journey->departure_time)
+		.Key("items"s).StartArray();
+
+	double time = journey->departure_time;
+	for (const auto& ride : journey->rides) {
+		builder.StartDict()
+			.Key("type"s).Value("Wait"s)
+			.Key("stop_name"s).Value(ride.stop->name)
+			.Key("time"s).Value(ride.departure_time - time)
+			.EndDict();
+		builder.StartDict()
+			.Key("type"s).Value("Bus"s)
+			.Key("bus"s).Value(ride.bus->name)
+			.Key("departure_time"s).Value(ride.departure_time)
+			.Key("time"s).Value(ride.arrival_time - ride.departure_time)
+			.Key("span_count"s).Value(static_cast<int>(ride.span_count))
+			.EndDict();
+		time = ride.arrival_time;
+	}
+
+	builder.EndArray();
+}
+
+json::Node JSONReader::ProcessQuery(const json::Dict& map_req, const RequestHandler& handler) const {
     using namespace std::string_literals;
-	using namespace std::string_view_literals;
+
+	int request_id = map_req.at("id"s).AsInt();
+	std::string type = map_req.at("type"s).AsString();
 
 	json::Builder builder;
+	builder.StartDict().Key("request_id").Value(request_id);
 
-	builder.StartArray();
+	if (type == "Stop"s) {
+		std::string name = map_req.at("name"s).AsString();
+		PrintStops(handler, name, builder);
+	}
+	else if (type == "Bus"s) {
+		std::string name = map_req.at("name"s).AsString();
+		PrintBuses(handler, name, builder);
+	}
+	else if (type == "Map"s) {
+		PrintMap(handler, map_req, builder);
+	}
+	else if (type == "Nearby"s) {
+		PrintNearby(handler, map_req, builder);
+	}
+	else if (type == "Route"s && map_req.count("departure_time"s) != 0) {
+		PrintJourney(handler, map_req, builder);
+	}
+	else if (type == "Route"s) {
+		std::string from = map_req.at("from"s).AsString();
+		std::string to = map_req.at("to"s).AsString();
+		PrintRoute(handler, from, to, builder);
+	}
+	else if (type == "RouteMatrix"s) {
+		PrintRouteMatrix(handler, map_req, builder);
+	}
+	else if (type == "Isochrone"s) {
+		PrintIsochrone(handler, map_req, builder);
+	}
+	builder.EndDict();
+	return builder.Build();
+}
 
-	for (const json::Node& request : data) {
-		auto map_req = request.AsDict();
-		int request_id = map_req.at("id"s).AsInt();
-		std::string type = map_req.at("type"s).AsString();
+//    ,      
+constexpr size_t QUERY_CHUNK_SIZE = 64;
+//        
+constexpr size_t PENDING_CHUNKS_PER_THREAD = 4;
+
+struct PrintedChunk {
+	std::string text;
+	//     text
+	std::vector<size_t> element_ends;
+	std::exception_ptr error;
+	bool is_ready = false;
+};
+
+//      ,        .
+//         PENDING_CHUNKS_PER_THREAD  
+void JSONReader::ProcessQueriesInParallel(const json::Array& data, const RequestHandler& handler,
+	json::ArrayPrinter& printer, size_t thread_count) const {
+	const size_t chunk_count = (data.size() + QUERY_CHUNK_SIZE - 1) / QUERY_CHUNK_SIZE;
+	const size_t max_pending_chunks = thread_count * PENDING_CHUNKS_PER_THREAD;
+
+	std::vector<PrintedChunk> chunks(chunk_count);
+	std::mutex mutex;
+	std::condition_variable chunk_ready;
+	std::condition_variable chunk_written;
+	size_t next_chunk = 0;
+	size_t written_chunks = 0;
+
+	auto process_chunks = [&]() {
+		while (true) {
+			size_t chunk_idx = 0;
+			{
+				std::unique_lock lock(mutex);
+				chunk_written.wait(lock, [&] {
+					return next_chunk == chunk_count || next_chunk < written_chunks + max_pending_chunks;
+					});
+				if (next_chunk == chunk_count) {
+					return;
+				}
+				chunk_idx = next_chunk++;
+			}
 
-		builder.StartDict().Key("request_id").Value(request_id);
+			PrintedChunk chunk;
+			std::ostringstream stream;
+			try {
+				const size_t end = std::min(data.size(), (chunk_idx + 1) * QUERY_CHUNK_SIZE);
+				for (size_t idx = chunk_idx * QUERY_CHUNK_SIZE; idx < end; ++idx) {
+					json::PrintArrayElement(ProcessQuery(data[idx].AsDict(), handler), stream);
+					chunk.element_ends.push_back(static_cast<size_t>(stream.tellp()));
+				}
+			}
+			catch (...) {
+				//     ,     
+				chunk.error = std::current_exception();
+			}
+			chunk.text = stream.str();
+			chunk.is_ready = true;
 
-		if (type == "Stop"s) {
-			std::string name = map_req.at("name"s).AsString();
-			PrintStops(handler, name, builder);
+			{
+				std::lock_guard lock(mutex);
+				chunks[chunk_idx] = std::move(chunk);
+			}
+			chunk_ready.notify_all();
 		}
-		else if (type == "Bus"s) {
-			std::string name = map_req.at("name"s).AsString();
-			PrintBuses(handler, name, builder);
+	};
+
+	std::vector<std::thread> workers;
+	workers.reserve(thread_count);
+	for (size_t i = 0; i < thread_count; ++i) {
+		workers.emplace_back(process_chunks);
+	}
+
+	//     ,     
+	auto join_workers = [&]() {
+		{
+			std::lock_guard lock(mutex);
+			next_chunk = chunk_count;
 		}
-		else if (type == "Map"s) {
-			PrintMap(handler, builder);
+		chunk_written.notify_all();
+		for (auto& worker : workers) {
+			worker.join();
 		}
-		if (type == "Route"s) {
-			std::string from = map_req.at("from"s).AsString();
-			std::string to = map_req.at("to"s).AsString();
-			PrintRoute(handler, from, to, builder);
+	};
+
+	try {
+		for (size_t chunk_idx = 0; chunk_idx < chunk_count; ++chunk_idx) {
+			PrintedChunk chunk;
+			{
+				std::unique_lock lock(mutex);
+				chunk_ready.wait(lock, [&] {
+					return chunks[chunk_idx].is_ready;
+					});
+				chunk = std::move(chunks[chunk_idx]);
+				++written_chunks;
+			}
+			chunk_written.notify_all();
+
+			const std::string_view text = chunk.text;
+			size_t element_begin = 0;
+			for (const size_t element_end : chunk.element_ends) {
+				printer.PrintPrinted(text.substr(element_begin, element_end - element_begin));
+				element_begin = element_end;
+			}
+			if (chunk.error) {
+				std::rethrow_exception(chunk.error);
+			}
 		}
-		builder.EndDict();
 	}
-	builder.EndArray();
+	catch (...) {
+		join_workers();
+		throw;
+	}
+	join_workers();
+}
+
+void JSONReader::ProcessQueries(const json::Array& data, RequestHandler& handler, std::ostream& out,
+	const StatSettings& settings) const {
+	//      
+	json::ArrayPrinter printer(out);
 
-    json::Print(json::Document(builder.Build()), out);
+	if (settings.thread_count > 1 && data.size() > QUERY_CHUNK_SIZE) {
+		ProcessQueriesInParallel(data, handler, printer, settings.thread_count);
+	}
+	else {
+		for (const json::Node& request : data) {
+			printer.Print(ProcessQuery(request.AsDict(), handler));
+		}
+	}
+	printer.Finish();
 }
 
 } // end namespace transport::reader
@@ -7,36 +7,78 @@
 #include "transport_router.h"
 #include "graph.h"
 #include "request_handler.h"
+#include "serialization.h"
+#include "server.h"
 
 #include <algorithm>
+#include <istream>
+#include <map>
+#include <optional>
+#include <string_view>
 
 namespace transport::reader {
 
+struct StatSettings {
+	// ,  stat_requests;     
+	size_t thread_count = 1;
+};
+
 class JSONReader {
 public:
 	JSONReader(Catalogue& catalogue);
 
 	//     
-	void FillDataBase(json::Array& data); 
+	void FillDataBase(const json::Array& data);
+	//  update_requests   : "Stop"    
+	//   , "Bus"    , "RemoveBus"  
+	void ApplyUpdates(const json::Array& data);
+	//    : base_requests      ,
+	//    
+	json::Dict ReadDocument(std::istream& input);
+	json::Dict ReadDocument(std::string_view text);
 	//    
 	renderer::RenderSettings ReadRenderSettings(const json::Dict& data);
 	//  bus_wait_time  bus_velocity
 	router::RoutingSettings ReadRoutingSettings(const json::Dict& data);
+	//      
+	static serialization::SerializationSettings ReadSerializationSettings(const json::Dict& data);
+	//    
+	StatSettings ReadStatSettings(const json::Dict& data);
+	//    : "unix_socket"  "port"
+	static server::ServerSettings ReadServerSettings(const json::Dict& data);
 	//       
-	void ProcessQueries(json::Array& data, RequestHandler& handler, std::ostream& out) const;
+	void ProcessQueries(const json::Array& data, RequestHandler& handler, std::ostream& out,
+		const StatSettings& settings = {}) const;
+	//    ;    
+	json::Node ProcessQuery(const json::Dict& map_req, const RequestHandler& handler) const;
 
 private:
-	void AddStopsToDataBase(json::Array& data, std::map<std::string, json::Dict>& distances);
+	class DocumentHandler;
+
+	void AddStopToDataBase(const json::Dict& req_map, std::map<std::string, json::Dict>& distances);
+	void AddStopsToDataBase(const json::Array& data, std::map<std::string, json::Dict>& distances);
 	void AddDistancesToDataBase(std::map<std::string, json::Dict>& distances);
-	void AddRoutesToDataBase(json::Array& data);
+	void AddRoutesToDataBase(const json::Array& data);
+	void AddRouteToDataBase(const json::Dict& req_map);
+
+	void ProcessQueriesInParallel(const json::Array& data, const RequestHandler& handler,
+		json::ArrayPrinter& printer, size_t thread_count) const;
 
 	void PrintStops(const RequestHandler& handler, std::string& name,
 		json::Builder& builder) const;
 	void PrintBuses(const RequestHandler& handler, std::string& name,
 		json::Builder& builder) const;
-	void PrintMap(const RequestHandler& handler, json::Builder& builder) const;
+	void PrintMap(const RequestHandler& handler, const json::Dict& map_req, json::Builder& builder) const;
+	void PrintNearby(const RequestHandler& handler, const json::Dict& map_req,
+		json::Builder& builder) const;
 	void PrintRoute(const RequestHandler& handler, std::string& from,
 		std::string& to, json::Builder& builder) const;
+	void PrintRouteMatrix(const RequestHandler& handler, const json::Dict& map_req,
+		json::Builder& builder) const;
+	void PrintIsochrone(const RequestHandler& handler, const json::Dict& map_req,
+		json::Builder& builder) const;
+	void PrintJourney(const RequestHandler& handler, const json::Dict& map_req,
+		json::Builder& builder) const;
 
 	Catalogue& catalogue_;
 };
@@ -1,37 +1,212 @@
 #include "json_reader.h"
 #include "request_handler.h"
+#include "serialization.h"
+#include "server.h"
+#include "snapshot.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
 
 using namespace std;
 
-int main() {
-    transport::Catalogue catalogue;
+namespace {
+
+//   :       
+std::string ReadAll(std::istream& in) {
+    std::string text;
+    char chunk[1 << 16];
+    while (in.read(chunk, sizeof(chunk)) || in.gcount() > 0) {
+        text.append(chunk, static_cast<size_t>(in.gcount()));
+    }
+    return text;
+}
 
-    json::Array json;
-    json::Dict json_render_settings;
-    json::Dict json_router_settings;
+void PrintUsage(std::ostream& stream = std::cerr) {
+    stream << "Usage: transport_catalogue [make_base|update_base|process_requests|serve]\n"sv;
+}
+
+//           serialization_settings
+void MakeBase(std::istream& in) {
+    transport::Catalogue catalogue;
     transport::router::RoutingSettings routing_settings;
     renderer::RenderSettings render_settings;
 
-    auto doc = json::Load(std::cin).GetRoot().AsDict();
-
+    // base_requests      
     transport::reader::JSONReader json_reader(catalogue);
+    const auto doc = json_reader.ReadDocument(ReadAll(in));
+
+    if (doc.find("render_settings"s) != doc.end()) {
+        render_settings = json_reader.ReadRenderSettings(doc.at("render_settings"s).AsDict());
+    }
+    if (doc.find("routing_settings"s) != doc.end()) {
+        routing_settings = json_reader.ReadRoutingSettings(doc.at("routing_settings"s).AsDict());
+    }
+
+    const auto settings = json_reader.ReadSerializationSettings(doc.at("serialization_settings"s).AsDict());
+    transport::router::TransportRouter transport_router(routing_settings, catalogue);
+    serialization::SaveTransportBase(settings.file, catalogue, render_settings, transport_router);
+}
+
+//  update_requests        .
+//    ,   ,    
+void UpdateBase(std::istream& in) {
+    const auto json_doc = json::Load(ReadAll(in));
+    const auto& doc = json_doc.GetRoot().AsDict();
 
-    //   
-    if (doc.find("base_requests"s) != doc.end()) {
-        json = doc.at("base_requests"s).AsArray();
-        json_reader.FillDataBase(json);
+    const auto settings = transport::reader::JSONReader::ReadSerializationSettings(
+        doc.at("serialization_settings"s).AsDict());
+    serialization::TransportBase base(settings.file);
+
+    transport::reader::JSONReader json_reader(base.GetCatalogue());
+    json_reader.ApplyUpdates(doc.at("update_requests"s).AsArray());
+    base.Update();
+    base.Save(settings.file);
+}
+
+//      stat_requests
+void ProcessRequests(std::istream& in, std::ostream& out) {
+    const auto json_doc = json::Load(ReadAll(in));
+    const auto& doc = json_doc.GetRoot().AsDict();
+
+    const auto settings = transport::reader::JSONReader::ReadSerializationSettings(
+        doc.at("serialization_settings"s).AsDict());
+    serialization::TransportBase base(settings.file);
+
+    if (doc.find("stat_requests"s) != doc.end()) {
+        transport::reader::JSONReader json_reader(base.GetCatalogue());
+        RequestHandler handler(base.GetCatalogue(), base.GetRenderer(), base.GetRouter());
+
+        transport::reader::StatSettings stat_settings;
+        if (doc.find("stat_settings"s) != doc.end()) {
+            stat_settings = json_reader.ReadStatSettings(doc.at("stat_settings"s).AsDict());
+        }
+        json_reader.ProcessQueries(doc.at("stat_requests"s).AsArray(), handler, out, stat_settings);
+    }
+}
+
+// ,   SIGINT  SIGTERM
+server::QueryServer* running_server = nullptr;
+
+extern "C" void StopServer(int) {
+    if (running_server != nullptr) {
+        running_server->Stop();
+    }
+}
+
+//    ,      :    
+struct ServedBase {
+    explicit ServedBase(const std::filesystem::path& path)
+        : base(path)
+        , json_reader(base.GetCatalogue())
+        , handler(base.GetCatalogue(), base.GetRenderer(), base.GetRouter()) {
     }
 
+    serialization::TransportBase base;
+    transport::reader::JSONReader json_reader;
+    RequestHandler handler;
+};
+
+//    ,     
+constexpr auto BASE_CHECK_INTERVAL = std::chrono::seconds(1);
+
+//           server_settings.
+//     (,  update_base),   
+//     ;       
+void Serve(std::istream& in) {
+    const auto json_doc = json::Load(ReadAll(in));
+    const auto& doc = json_doc.GetRoot().AsDict();
+
+    const auto settings = transport::reader::JSONReader::ReadSerializationSettings(
+        doc.at("serialization_settings"s).AsDict());
+    const auto server_settings = transport::reader::JSONReader::ReadServerSettings(
+        doc.at("server_settings"s).AsDict());
+
+    auto base_time = std::filesystem::last_write_time(settings.file);
+    server::SnapshotHolder<ServedBase> versions(std::make_unique<ServedBase>(settings.file));
+    //      poll
+    const auto reader = versions.MakeReader();
+
+    server::QueryServer query_server(server_settings, [&](const json::Dict& request) {
+        const auto version = reader.Lock();
+        return version->json_reader.ProcessQuery(request, version->handler);
+    });
+
+    std::mutex reload_mutex;
+    std::condition_variable reload_stopped;
+    bool is_stopped = false;
+    std::thread reload_thread([&] {
+        std::unique_lock lock(reload_mutex);
+        while (!reload_stopped.wait_for(lock, BASE_CHECK_INTERVAL, [&] { return is_stopped; })) {
+            // ,     
+            versions.Collect();
+
+            std::error_code error;
+            const auto time = std::filesystem::last_write_time(settings.file, error);
+            if (error || time == base_time) {
+                continue;
+            }
+            try {
+                versions.Publish(std::make_unique<ServedBase>(settings.file));
+                base_time = time;
+            }
+            catch (const std::exception& load_error) {
+                //      
+                std::cerr << "Cannot reload "sv << settings.file.string() << ": "sv << load_error.what() << '\n';
+                base_time = time;
+            }
+        }
+    });
+
+    running_server = &query_server;
+    std::signal(SIGINT, StopServer);
+    std::signal(SIGTERM, StopServer);
+    query_server.Run();
+    std::signal(SIGINT, SIG_DFL);
+    std::signal(SIGTERM, SIG_DFL);
+    running_server = nullptr;
+
+    {
+        const std::lock_guard lock(reload_mutex);
+        is_stopped = true;
+    }
+    reload_stopped.notify_one();
+    reload_thread.join();
+}
+
+//        
+void MakeBaseAndProcessRequests(std::istream& in, std::ostream& out) {
+    transport::Catalogue catalogue;
+
+    transport::router::RoutingSettings routing_settings;
+    renderer::RenderSettings render_settings;
+    transport::reader::StatSettings stat_settings;
+
+    transport::reader::JSONReader json_reader(catalogue);
+
+    //       
+    const auto doc = json_reader.ReadDocument(ReadAll(in));
+
     //    
     if (doc.find("render_settings"s) != doc.end()) {
-        json_render_settings = doc.at("render_settings"s).AsDict();
-        render_settings = json_reader.ReadRenderSettings(json_render_settings);
+        render_settings = json_reader.ReadRenderSettings(doc.at("render_settings"s).AsDict());
     }
 
     //  bus_wait_time  bus_velocity
     if (doc.find("routing_settings"s) != doc.end()) {
-        json_router_settings = doc.at("routing_settings"s).AsDict();
-        routing_settings = json_reader.ReadRoutingSettings(json_router_settings);
+        routing_settings = json_reader.ReadRoutingSettings(doc.at("routing_settings"s).AsDict());
+    }
+
+    //     
+    if (doc.find("stat_settings"s) != doc.end()) {
+        stat_settings = json_reader.ReadStatSettings(doc.at("stat_settings"s).AsDict());
     }
 
     //     
@@ -43,7 +218,33 @@ int main() {
 
         RequestHandler handler(catalogue, map_renderer, transport_router);
 
-        json = doc.at("stat_requests"s).AsArray();
-        json_reader.ProcessQueries(json, handler, std::cout);
+        json_reader.ProcessQueries(doc.at("stat_requests"s).AsArray(), handler, out, stat_settings);
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc == 1) {
+        MakeBaseAndProcessRequests(std::cin, std::cout);
+        return 0;
+    }
+
+    const std::string_view mode(argv[1]);
+    if (argc == 2 && mode == "make_base"sv) {
+        MakeBase(std::cin);
+    }
+    else if (argc == 2 && mode == "update_base"sv) {
+        UpdateBase(std::cin);
+    }
+    else if (argc == 2 && mode == "process_requests"sv) {
+        ProcessRequests(std::cin, std::cout);
+    }
+    else if (argc == 2 && mode == "serve"sv) {
+        Serve(std::cin);
+    }
+    else {
+        PrintUsage();
+        return 1;
     }
 }
\ No newline at end of file
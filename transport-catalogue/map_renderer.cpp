@@ -1,6 +1,8 @@
 #include "map_renderer.h"
 #include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <unordered_set>
 
 namespace renderer { 
 
@@ -40,136 +42,288 @@ MapRenderer::MapRenderer(RenderSettings render_settings, const std::vector<trans
         stops_positions_[stop] = sphere_projector(stop->coordinates);
     }
 
+    FillItems();
 }
 
-bool MapRenderer::LexicCompareByName::operator()(transport::detail::Stop* lhs, transport::detail::Stop* rhs) const {
-    return lhs->name < rhs->name;
-}
-
-void MapRenderer::DrawBuses(svg::Document& doc) const {
-    int color_index = 0;
+//  :  ,  ,  ,  
+void MapRenderer::FillItems() {
+    using Kind = MapItem::Kind;
 
+    size_t color_index = 0;
     for (const auto& bus : buses_) {
-        auto& stops = bus->stops;
-
-        if (stops.empty()) {
+        if (bus->stops.empty()) {
             continue;  //    
         }
-
-        svg::Polyline polyline;
-        polyline.SetStrokeColor(GetBusLineColor(color_index++))
-            .SetStrokeWidth(render_settings_.line_width)
-            .SetStrokeLineCap(svg::StrokeLineCap::ROUND)
-            .SetStrokeLineJoin(svg::StrokeLineJoin::ROUND)
-            .SetFillColor(svg::NoneColor);
-
-        for (const auto& stop : stops) {
-            polyline.AddPoint(stops_positions_.at(stop));
-        }
-
-        doc.Add(std::move(polyline));
+        items_.push_back({ Kind::BUS_LINE, bus, nullptr, {}, color_index++ });
     }
-}
-
-void MapRenderer::DrawBusesNames(svg::Document& doc) const {
-    using namespace std::string_literals;
-    int color_index = 0;
 
+    color_index = 0;
     for (const auto& bus : buses_) {
         if (bus->stops.empty()) {
-            continue;  //    
+            continue;
         }
 
         //1  
         auto stop = bus->final_stops.front();
-        auto& bus_color = GetBusLineColor(color_index);
-
-        auto base = svg::Text()
-            .SetPosition(stops_positions_.at(stop))
-            .SetOffset(render_settings_.bus_label_offset)
-            .SetFontSize(render_settings_.bus_label_font_size)
-            .SetFontFamily("Verdana"s)
-            .SetFontWeight("bold"s)
-            .SetData(bus->name);
-
-        doc.Add(svg::Text{ base }
-            .SetFillColor(render_settings_.underlayer_color)
-            .SetStrokeColor(render_settings_.underlayer_color)
-            .SetStrokeWidth(render_settings_.underlayer_width)
-            .SetStrokeLineCap(svg::StrokeLineCap::ROUND)
-            .SetStrokeLineJoin(svg::StrokeLineJoin::ROUND));
-
-        doc.Add(svg::Text{ base }.SetFillColor(bus_color));
+        items_.push_back({ Kind::BUS_LABEL, bus, stop, stops_positions_.at(stop), color_index });
 
         //2  
         if (!bus->is_roundtrip && stop != bus->final_stops.back()) {
             auto stop2 = bus->final_stops.back();
-            auto& bus_color2 = GetBusLineColor(color_index);
-
-            auto base2 = svg::Text()
-                .SetPosition(stops_positions_.at(stop2))
-                .SetOffset(render_settings_.bus_label_offset)
-                .SetFontSize(render_settings_.bus_label_font_size)
-                .SetFontFamily("Verdana"s)
-                .SetFontWeight("bold"s)
-                .SetData(bus->name);
-
-            doc.Add(svg::Text{ base2 }
-                .SetFillColor(render_settings_.underlayer_color)
-                .SetStrokeColor(render_settings_.underlayer_color)
-                .SetStrokeWidth(render_settings_.underlayer_width)
-                .SetStrokeLineCap(svg::StrokeLineCap::ROUND)
-                .SetStrokeLineJoin(svg::StrokeLineJoin::ROUND));
-
-            doc.Add(svg::Text{ base2 }.SetFillColor(bus_color2));
-            
+            items_.push_back({ Kind::BUS_LABEL, bus, stop2, stops_positions_.at(stop2), color_index });
         }
         color_index++;
     }
+
+    for (const auto& [stop, position] : stops_positions_) {
+        items_.push_back({ Kind::STOP_CIRCLE, nullptr, stop, position });
+    }
+    for (const auto& [stop, position] : stops_positions_) {
+        items_.push_back({ Kind::STOP_LABEL, nullptr, stop, position });
+    }
 }
 
-void MapRenderer::DrawStopsCircle(svg::Document& doc) const {
-    using namespace std::string_literals;
+const RenderSettings& MapRenderer::GetSettings() const {
+    return render_settings_;
+}
 
-    for (const auto& [key, position] : stops_positions_) {
-        svg::Circle circle;
-        circle.SetCenter(position)
-            .SetRadius(render_settings_.stop_radius)
-            .SetFillColor("white"s);
+bool MapRenderer::LexicCompareByName::operator()(transport::detail::Stop* lhs, transport::detail::Stop* rhs) const {
+    return lhs->name < rhs->name;
+}
 
-        doc.Add(std::move(circle));
+void MapRenderer::DrawItem(const MapItem& item, svg::Document& doc, const spatial::Rect* area) const {
+    switch (item.kind) {
+    case MapItem::Kind::BUS_LINE:
+        DrawBusLine(item, doc, area);
+        break;
+    case MapItem::Kind::BUS_LABEL:
+        DrawBusLabel(item, doc);
+        break;
+    case MapItem::Kind::STOP_CIRCLE:
+        DrawStopCircle(item, doc);
+        break;
+    case MapItem::Kind::STOP_LABEL:
+        DrawStopLabel(item, doc);
+        break;
     }
 }
 
-void MapRenderer::DrawStopsNames(svg::Document& doc) const {
+//            .
+//      ,     
+void MapRenderer::DrawBusLine(const MapItem& item, svg::Document& doc, const spatial::Rect* area) const {
+    std::vector<svg::Point> points;
+    points.reserve(item.bus->stops.size());
+    for (const auto& stop : item.bus->stops) {
+        points.push_back(stops_positions_.at(stop));
+    }
+
+    size_t begin = 0;
+    size_t end = points.size();
+    if (area != nullptr && points.size() > 1) {
+        const auto is_visible = [&](size_t segment) {
+            return GetSegmentBox(points[segment], points[segment + 1]).Intersects(*area);
+        };
+        while (begin + 1 < end && !is_visible(begin)) {
+            ++begin;
+        }
+        while (end > begin + 2 && !is_visible(end - 2)) {
+            --end;
+        }
+    }
+
+    svg::Polyline polyline;
+    polyline.SetStrokeColor(GetBusLineColor(item.color_index))
+        .SetStrokeWidth(render_settings_.line_width)
+        .SetStrokeLineCap(svg::StrokeLineCap::ROUND)
+        .SetStrokeLineJoin(svg::StrokeLineJoin::ROUND)
+        .SetFillColor(svg::NoneColor);
+
+    for (size_t idx = begin; idx < end; ++idx) {
+        polyline.AddPoint(points[idx]);
+    }
+
+    doc.Add(std::move(polyline));
+}
+
+void MapRenderer::DrawBusLabel(const MapItem& item, svg::Document& doc) const {
     using namespace std::string_literals;
 
-    for (const auto& [key, position] : stops_positions_) {
-        auto base = svg::Text()
-            .SetPosition(position)
-            .SetOffset(render_settings_.stop_label_offset)
-            .SetFontSize(render_settings_.stop_label_font_size)
-            .SetFontFamily("Verdana"s)
-            .SetData(key->name);
+    auto base = svg::Text()
+        .SetPosition(item.position)
+        .SetOffset(render_settings_.bus_label_offset)
+        .SetFontSize(render_settings_.bus_label_font_size)
+        .SetFontFamily("Verdana"s)
+        .SetFontWeight("bold"s)
+        .SetData(item.bus->name);
+
+    doc.Add(svg::Text{ base }
+        .SetFillColor(render_settings_.underlayer_color)
+        .SetStrokeColor(render_settings_.underlayer_color)
+        .SetStrokeWidth(render_settings_.underlayer_width)
+        .SetStrokeLineCap(svg::StrokeLineCap::ROUND)
+        .SetStrokeLineJoin(svg::StrokeLineJoin::ROUND));
+
+    doc.Add(svg::Text{ base }.SetFillColor(GetBusLineColor(item.color_index)));
+}
 
-        doc.Add(svg::Text{ base }
-            .SetFillColor(render_settings_.underlayer_color)
-            .SetStrokeColor(render_settings_.underlayer_color)
-            .SetStrokeWidth(render_settings_.underlayer_width)
-            .SetStrokeLineCap(svg::StrokeLineCap::ROUND)
-            .SetStrokeLineJoin(svg::StrokeLineJoin::ROUND));
+void MapRenderer::DrawStopCircle(const MapItem& item, svg::Document& doc) const {
+    using namespace std::string_literals;
 
-        doc.Add(svg::Text{ base }.SetFillColor("black"s));
+    svg::Circle circle;
+    circle.SetCenter(item.position)
+        .SetRadius(render_settings_.stop_radius)
+        .SetFillColor("white"s);
+
+    doc.Add(std::move(circle));
+}
+
+void MapRenderer::DrawStopLabel(const MapItem& item, svg::Document& doc) const {
+    using namespace std::string_literals;
+
+    auto base = svg::Text()
+        .SetPosition(item.position)
+        .SetOffset(render_settings_.stop_label_offset)
+        .SetFontSize(render_settings_.stop_label_font_size)
+        .SetFontFamily("Verdana"s)
+        .SetData(item.stop->name);
+
+    doc.Add(svg::Text{ base }
+        .SetFillColor(render_settings_.underlayer_color)
+        .SetStrokeColor(render_settings_.underlayer_color)
+        .SetStrokeWidth(render_settings_.underlayer_width)
+        .SetStrokeLineCap(svg::StrokeLineCap::ROUND)
+        .SetStrokeLineJoin(svg::StrokeLineJoin::ROUND));
+
+    doc.Add(svg::Text{ base }.SetFillColor("black"s));
+}
+
+svg::Document MapRenderer::MakeDocument() const {
+    svg::Document doc;
+    for (const auto& item : items_) {
+        DrawItem(item, doc);
     }
+    return doc;
 }
 
 void MapRenderer::Render(std::ostream& out) const {
+    MakeDocument().Render(out);
+}
+
+const std::string& MapRenderer::GetRenderedMap() const {
+    std::call_once(rendered_map_->once, [this] {
+        MakeDocument().Render(rendered_map_->svg);
+    });
+    return rendered_map_->svg;
+}
+
+std::string MapRenderer::RenderArea(const spatial::Rect& area) const {
     svg::Document doc;
-    DrawBuses(doc);
-    DrawBusesNames(doc);
-    DrawStopsCircle(doc);
-    DrawStopsNames(doc);
-    doc.Render(out);
+    doc.SetViewBox(area.min_x, area.min_y, area.max_x - area.min_x, area.max_y - area.min_y);
+    for (const size_t id : GetIndex().Query(area)) {
+        DrawItem(items_[id], doc, &area);
+    }
+
+    std::string svg;
+    doc.Render(svg);
+    return svg;
+}
+
+std::optional<spatial::Rect> MapRenderer::GetTileArea(int zoom, int x, int y) const {
+    //  2^30       int
+    if (zoom < 0 || zoom > 30) {
+        return std::nullopt;
+    }
+    const int tile_count = 1 << zoom;
+    if (x < 0 || y < 0 || x >= tile_count || y >= tile_count) {
+        return std::nullopt;
+    }
+
+    const double tile_width = render_settings_.width / tile_count;
+    const double tile_height = render_settings_.height / tile_count;
+    return spatial::Rect{ x * tile_width, y * tile_height, (x + 1) * tile_width, (y + 1) * tile_height };
+}
+
+std::string MapRenderer::RenderIsochrone(const std::vector<transport::detail::StopTime>& stop_times, double max_time) const {
+    svg::Document doc;
+    for (const auto& [stop, time] : stop_times) {
+        //    ,     
+        const auto it = stops_positions_.find(const_cast<transport::detail::Stop*>(stop));
+        if (it == stops_positions_.end()) {
+            continue;
+        }
+
+        const double share = max_time > 0 ? std::clamp(time / max_time, 0.0, 1.0) : 0.0;
+        svg::Circle circle;
+        circle.SetCenter(it->second)
+            .SetRadius(render_settings_.stop_radius * 2)
+            .SetFillColor(svg::Rgba(static_cast<uint8_t>(std::lround(255 * share)),
+                static_cast<uint8_t>(std::lround(255 * (1 - share))), 0, 0.6));
+        doc.Add(std::move(circle));
+    }
+
+    std::string svg;
+    doc.Render(svg);
+    return svg;
+}
+
+const spatial::GridIndex& MapRenderer::GetIndex() const {
+    std::call_once(index_->once, [this] {
+        std::vector<spatial::GridIndex::Entry> entries;
+        for (size_t id = 0; id < items_.size(); ++id) {
+            AddItemBoxes(id, entries);
+        }
+        index_->grid = spatial::GridIndex(std::move(entries));
+    });
+    return index_->grid;
+}
+
+//           
+void MapRenderer::AddItemBoxes(size_t id, std::vector<spatial::GridIndex::Entry>& entries) const {
+    const MapItem& item = items_[id];
+    switch (item.kind) {
+    case MapItem::Kind::BUS_LINE: {
+        const auto& stops = item.bus->stops;
+        svg::Point prev = stops_positions_.at(stops.front());
+        for (size_t idx = 0; idx < stops.size(); ++idx) {
+            const svg::Point point = stops_positions_.at(stops[idx]);
+            entries.push_back({ id, GetSegmentBox(prev, point) });
+            prev = point;
+        }
+        break;
+    }
+    case MapItem::Kind::BUS_LABEL: {
+        const svg::Point anchor{ item.position.x + render_settings_.bus_label_offset.x,
+            item.position.y + render_settings_.bus_label_offset.y };
+        entries.push_back({ id, GetLabelBox(anchor, render_settings_.bus_label_font_size, item.bus->name.size()) });
+        break;
+    }
+    case MapItem::Kind::STOP_CIRCLE: {
+        const double radius = render_settings_.stop_radius;
+        entries.push_back({ id, { item.position.x - radius, item.position.y - radius,
+            item.position.x + radius, item.position.y + radius } });
+        break;
+    }
+    case MapItem::Kind::STOP_LABEL: {
+        const svg::Point anchor{ item.position.x + render_settings_.stop_label_offset.x,
+            item.position.y + render_settings_.stop_label_offset.y };
+        entries.push_back({ id, GetLabelBox(anchor, render_settings_.stop_label_font_size, item.stop->name.size()) });
+        break;
+    }
+    }
+}
+
+spatial::Rect MapRenderer::GetSegmentBox(svg::Point from, svg::Point to) const {
+    const double half_width = render_settings_.line_width / 2;
+    return { std::min(from.x, to.x) - half_width, std::min(from.y, to.y) - half_width,
+        std::max(from.x, to.x) + half_width, std::max(from.y, to.y) + half_width };
+}
+
+//     :     ,  
+//          .  
+spatial::Rect MapRenderer::GetLabelBox(svg::Point anchor, int font_size, size_t length) const {
+    const double underlayer = render_settings_.underlayer_width / 2;
+    return { anchor.x - underlayer, anchor.y - font_size - underlayer,
+        anchor.x + static_cast<double>(font_size) * length + underlayer, anchor.y + font_size / 2.0 + underlayer };
 }
 
 inline const double EPSILON = 1e-6;
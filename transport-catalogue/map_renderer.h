@@ -1,12 +1,16 @@
 #pragma once
 
+#include "grid_index.h"
 #include "svg.h"
 #include "transport_catalogue.h"
 
 #include <algorithm>
 #include <cstdlib>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <string>
 #include <vector>
 #include <array>
 #include <map>
@@ -56,15 +60,65 @@ public:
     MapRenderer() = default;
     MapRenderer(RenderSettings render_settings, const std::vector<transport::detail::bus::Bus*>& buses);
 
+    const RenderSettings& GetSettings() const;
     void Render(std::ostream& out) const;
+    //    SVG.    ,       ,
+    //    :     
+    const std::string& GetRenderedMap() const;
+    //   ,  area   ,    ,
+    //    .    - area
+    std::string RenderArea(const spatial::Rect& area) const;
+    //   x, y     2^zoom    .
+    //     nullopt
+    std::optional<spatial::Rect> GetTileArea(int zoom, int x, int y) const;
+    //     :      stop_times 
+    //   ( 0)   ( max_time).    
+    std::string RenderIsochrone(const std::vector<transport::detail::StopTime>& stop_times, double max_time) const;
 
 private:
+    struct RenderedMap {
+        std::once_flag once;
+        std::string svg;
+    };
+
+    //  .     
+    struct MapItem {
+        enum class Kind {
+            BUS_LINE,
+            BUS_LABEL,
+            STOP_CIRCLE,
+            STOP_LABEL,
+        };
+
+        Kind kind;
+        const transport::detail::bus::Bus* bus = nullptr;
+        const transport::detail::Stop* stop = nullptr;
+        //    
+        svg::Point position;
+        size_t color_index = 0;
+    };
+
+    //   ,    ;     
+    struct MapIndex {
+        std::once_flag once;
+        spatial::GridIndex grid;
+    };
+
     const svg::Color& GetBusLineColor(size_t index) const;
 
-    void DrawBuses(svg::Document& doc) const;
-    void DrawBusesNames(svg::Document& doc) const;
-    void DrawStopsCircle(svg::Document& doc) const;
-    void DrawStopsNames(svg::Document& doc) const;
+    void FillItems();
+    const spatial::GridIndex& GetIndex() const;
+    void AddItemBoxes(size_t id, std::vector<spatial::GridIndex::Entry>& entries) const;
+    spatial::Rect GetSegmentBox(svg::Point from, svg::Point to) const;
+    spatial::Rect GetLabelBox(svg::Point anchor, int font_size, size_t length) const;
+
+    svg::Document MakeDocument() const;
+    // area     
+    void DrawItem(const MapItem& item, svg::Document& doc, const spatial::Rect* area = nullptr) const;
+    void DrawBusLine(const MapItem& item, svg::Document& doc, const spatial::Rect* area) const;
+    void DrawBusLabel(const MapItem& item, svg::Document& doc) const;
+    void DrawStopCircle(const MapItem& item, svg::Document& doc) const;
+    void DrawStopLabel(const MapItem& item, svg::Document& doc) const;
 
     struct LexicCompareByName {
         bool operator()(transport::detail::Stop* lhs, transport::detail::Stop* rhs) const;
@@ -74,6 +128,10 @@ private:
     std::vector<transport::detail::bus::Bus*> buses_;
     //     
     std::map<transport::detail::Stop*, svg::Point, LexicCompareByName> stops_positions_;
+    std::vector<MapItem> items_;
+    //           
+    std::shared_ptr<RenderedMap> rendered_map_ = std::make_shared<RenderedMap>();
+    std::shared_ptr<MapIndex> index_ = std::make_shared<MapIndex>();
 };
 
 template <typename Iterator>
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <iterator>
 #include <string_view>
 #include <unordered_map>
@@ -33,4 +34,44 @@ auto AsRange(const C& container) {
     return Range{container.begin(), container.end()};
 }
 
+template <typename T>
+class CountingIterator {
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T*;
+    using reference = T;
+
+    explicit CountingIterator(T value)
+        : value_(value) {
+    }
+    T operator*() const {
+        return value_;
+    }
+    CountingIterator& operator++() {
+        ++value_;
+        return *this;
+    }
+    CountingIterator operator++(int) {
+        CountingIterator prev = *this;
+        ++value_;
+        return prev;
+    }
+    bool operator==(const CountingIterator& other) const {
+        return value_ == other.value_;
+    }
+    bool operator!=(const CountingIterator& other) const {
+        return value_ != other.value_;
+    }
+
+private:
+    T value_;
+};
+
+template <typename T>
+auto AsCountingRange(T begin, T end) {
+    return Range{CountingIterator<T>{begin}, CountingIterator<T>{end}};
+}
+
 }  // namespace ranges
\ No newline at end of file
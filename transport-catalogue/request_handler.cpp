@@ -1,4 +1,6 @@
 #include "request_handler.h"
+#include "json.h"
+
 #include <sstream>
 
 RequestHandler::RequestHandler(const transport::Catalogue& catalogue,
@@ -19,14 +21,41 @@ std::optional<const std::set<transport::detail::bus::Bus*, transport::detail::bu
 RequestHandler::GetBusesByStop(const std::string_view& stop_name) const {
     auto stop = catalogue_.FindStop(stop_name);
 
-    return stop ? std::make_optional(catalogue_.GetBusesByStop(stop->name)) : std::nullopt;
+    return stop ? std::make_optional(catalogue_.GetBusesByStop(stop)) : std::nullopt;
+}
+
+const std::string& RequestHandler::RenderMap() const {
+    return renderer_.GetRenderedMap();
+}
+
+std::string_view RequestHandler::RenderMapJson() const {
+    std::call_once(map_json_once_, [this] {
+        std::ostringstream out;
+        json::PrintString(RenderMap(), out);
+        map_json_ = out.str();
+    });
+    return map_json_;
+}
+
+std::string RequestHandler::RenderMapArea(const spatial::Rect& area) const {
+    return renderer_.RenderArea(area);
+}
+
+std::optional<spatial::Rect> RequestHandler::GetMapTileArea(int zoom, int x, int y) const {
+    return renderer_.GetTileArea(zoom, x, y);
 }
 
-std::string RequestHandler::RenderMap() const {
-    std::ostringstream render;
-    renderer_.Render(render);
+std::vector<transport::detail::StopDistance> RequestHandler::FindNearbyStops(geo::Coordinates point,
+    std::optional<size_t> count, std::optional<double> radius) const {
+    if (!radius.has_value()) {
+        return catalogue_.FindNearestStops(point, count.value_or(0));
+    }
 
-    return render.str();
+    auto stops = catalogue_.FindStopsInRadius(point, *radius);
+    if (count.has_value() && stops.size() > *count) {
+        stops.resize(*count);
+    }
+    return stops;
 }
 
 std::optional<transport::router::RouteInfo> RequestHandler::FindRoute(std::string_view stop_name_from,
@@ -37,4 +66,52 @@ std::optional<transport::router::RouteInfo> RequestHandler::FindRoute(std::strin
         return router_.FindRoute(from, to);
     }
     return std::nullopt;
-}
\ No newline at end of file
+}
+
+std::optional<transport::router::RouteMatrix> RequestHandler::ComputeRouteMatrix(
+    const std::vector<std::string_view>& stops_from, const std::vector<std::string_view>& stops_to) const {
+    const auto find_stops = [this](const std::vector<std::string_view>& names)
+        -> std::optional<std::vector<const transport::detail::Stop*>> {
+        std::vector<const transport::detail::Stop*> stops;
+        stops.reserve(names.size());
+        for (const auto name : names) {
+            const transport::detail::Stop* stop = catalogue_.FindStop(name);
+            if (stop == nullptr) {
+                return std::nullopt;
+            }
+            stops.push_back(stop);
+        }
+        return stops;
+    };
+
+    const auto from = find_stops(stops_from);
+    const auto to = find_stops(stops_to);
+    if (!from.has_value() || !to.has_value()) {
+        return std::nullopt;
+    }
+    return router_.ComputeRouteMatrix(*from, *to);
+}
+
+std::optional<std::vector<transport::detail::StopTime>> RequestHandler::FindReachableStops(
+    std::string_view stop_from, double max_time) const {
+    const transport::detail::Stop* from = catalogue_.FindStop(stop_from);
+    if (from == nullptr) {
+        return std::nullopt;
+    }
+    return router_.FindReachableStops(from, max_time);
+}
+
+std::string RequestHandler::RenderIsochrone(const std::vector<transport::detail::StopTime>& stop_times,
+    double max_time) const {
+    return renderer_.RenderIsochrone(stop_times, max_time);
+}
+
+std::optional<transport::router::Journey> RequestHandler::FindJourney(std::string_view stop_from,
+    std::string_view stop_to, double departure_time) const {
+    const transport::detail::Stop* from = catalogue_.FindStop(stop_from);
+    const transport::detail::Stop* to = catalogue_.FindStop(stop_to);
+    if (from == nullptr || to == nullptr) {
+        return std::nullopt;
+    }
+    return router_.FindJourney(from, to, departure_time);
+}
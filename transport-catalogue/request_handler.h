@@ -3,9 +3,12 @@
 #include "transport_router.h"
 #include "map_renderer.h"
 
+#include <mutex>
 #include <optional>
+#include <string>
 #include <string_view>
 #include <unordered_set>
+#include <vector>
 
 class RequestHandler {
 public:
@@ -21,15 +24,45 @@ public:
     [[nodiscard]] std::optional<const std::set<transport::detail::bus::Bus*, transport::detail::bus::PtrComparator>>
         GetBusesByStop(const std::string_view& stop_name) const;
 
-    //   
-    std::string RenderMap() const;
+    //   .    ,     
+    const std::string& RenderMap() const;
+    //  ,   JSON.   
+    std::string_view RenderMapJson() const;
+    //   ,   area
+    std::string RenderMapArea(const spatial::Rect& area) const;
+    //   , nullopt   
+    std::optional<spatial::Rect> GetMapTileArea(int zoom, int x, int y) const;
+
+    //    point   :   count    radius .
+    //  radius  count 
+    std::vector<transport::detail::StopDistance> FindNearbyStops(geo::Coordinates point,
+        std::optional<size_t> count, std::optional<double> radius) const;
 
     //   
     [[nodiscard]] std::optional<transport::router::RouteInfo>
         FindRoute(std::string_view stop_from, std::string_view stop_to) const;
 
+    //         stops_from  stops_to   .
+    // nullopt,  -    
+    [[nodiscard]] std::optional<transport::router::RouteMatrix>
+        ComputeRouteMatrix(const std::vector<std::string_view>& stops_from,
+            const std::vector<std::string_view>& stops_to) const;
+
+    // ,    stop_from    max_time ,   .
+    // nullopt,     
+    [[nodiscard]] std::optional<std::vector<transport::detail::StopTime>>
+        FindReachableStops(std::string_view stop_from, double max_time) const;
+    //         departure_time   
+    [[nodiscard]] std::optional<transport::router::Journey>
+        FindJourney(std::string_view stop_from, std::string_view stop_to, double departure_time) const;
+    //     
+    std::string RenderIsochrone(const std::vector<transport::detail::StopTime>& stop_times, double max_time) const;
+
 private:
     const transport::Catalogue& catalogue_;
     const renderer::MapRenderer& renderer_;
     const transport::router::TransportRouter& router_;
+
+    mutable std::once_flag map_json_once_;
+    mutable std::string map_json_;
 };
\ No newline at end of file
@@ -1,26 +1,85 @@
 #pragma once
 
+#include "contraction_hierarchy.h"
 #include "graph.h"
 
 #include <algorithm>
 #include <cassert>
+#include <condition_variable>
 #include <cstdint>
+#include <functional>
 #include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <stdexcept>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
 namespace graph {
 
-template <typename Weight>
-class Router {
+enum class RouterMode {
+    ALL_PAIRS,  // precomputed table of all shortest routes, O(V^2) memory
+    ON_DEMAND,  // Dijkstra search per query, O(V + E) memory
+    CONTRACTION_HIERARCHY,  // bidirectional search over a precomputed vertex hierarchy
+};
+
+// How a graph changed after a router was built for it. Vertices and edges of the old graph
+// are mapped to their ids in the new one; an edge whose weight changed counts as removed
+// and added again
+struct GraphChange {
+    static constexpr size_t REMOVED = std::numeric_limits<size_t>::max();
+
+    std::vector<VertexId> new_vertex_ids;  // REMOVED for vertices that are gone
+    std::vector<EdgeId> new_edge_ids;      // REMOVED for edges that are gone
+    std::vector<EdgeId> added_edges;       // ids in the new graph
+};
+
+namespace detail {
+
+// Reusable barrier: every Wait() returns once all participants have called it
+class ThreadBarrier {
+public:
+    explicit ThreadBarrier(size_t participant_count)
+        : participant_count_(participant_count) {
+    }
+
+    void Wait() {
+        std::unique_lock lock(mutex_);
+        const size_t generation = generation_;
+        if (++waiting_count_ == participant_count_) {
+            waiting_count_ = 0;
+            ++generation_;
+            condition_.notify_all();
+            return;
+        }
+        condition_.wait(lock, [this, generation] {
+            return generation != generation_;
+        });
+    }
+
 private:
-    using Graph = DirectedWeightedGraph<Weight>;
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    size_t participant_count_;
+    size_t waiting_count_ = 0;
+    size_t generation_ = 0;
+};
 
+}  // namespace detail
+
+template <typename Weight, typename Graph = DirectedWeightedGraph<Weight>>
+class Router {
 public:
-    explicit Router(const Graph& graph);
+    // thread_count only affects the ALL_PAIRS table build, the result does not depend on it
+    explicit Router(const Graph& graph, RouterMode mode = RouterMode::ALL_PAIRS,
+                    size_t thread_count = 1);
+    // Restores precomputed data written by Save, graph must be the one the data was built for
+    template <typename Archive>
+    Router(const Graph& graph, Archive& archive);
 
     struct RouteInfo {
         Weight weight;
@@ -29,89 +88,619 @@ public:
 
     std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
 
+    // Weights of routes from every source to every target, row by row:
+    // weights[i * targets.size() + j], nullopt for unreachable targets. Routes are not built:
+    // ON_DEMAND runs one search per source, CONTRACTION_HIERARCHY a many-to-many bucket search
+    std::vector<std::optional<Weight>> ComputeWeights(const std::vector<VertexId>& sources,
+                                                      const std::vector<VertexId>& targets) const;
+
+    // Vertices with routes from vertex from weighing at most max_weight, together with the
+    // weights, in no particular order. ALL_PAIRS reads a table row, other modes run one
+    // Dijkstra search over the graph that stops past max_weight
+    std::vector<std::pair<VertexId, Weight>> ComputeWeightsWithin(VertexId from, Weight max_weight) const;
+
+    // Catches up with the graph after it was replaced in place by the one change leads to.
+    // ALL_PAIRS recomputes only the rows whose routes used removed edges and relaxes the
+    // table through the added edges, CONTRACTION_HIERARCHY is built anew
+    void Update(const GraphChange& change, size_t thread_count = 1);
+
+    template <typename Archive>
+    void Save(Archive& archive) const;
+
 private:
     struct RouteInternalData {
         Weight weight;
         std::optional<EdgeId> prev_edge;
     };
-    using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
+
+    // Cell of the flat V x V route table, sentinels replace optionals
+    struct RouteCell {
+        Weight weight;
+        uint32_t prev_edge;
+    };
+    static constexpr Weight UNREACHABLE_WEIGHT = std::numeric_limits<Weight>::has_infinity
+                                               ? std::numeric_limits<Weight>::infinity()
+                                               : std::numeric_limits<Weight>::max();
+    static constexpr uint32_t NO_EDGE = std::numeric_limits<uint32_t>::max();
+
+    RouteCell* GetRouteCells(VertexId vertex_from) {
+        return routes_table_.data() + vertex_from * vertex_count_;
+    }
+    const RouteCell* GetRouteCells(VertexId vertex_from) const {
+        return routes_table_.data() + vertex_from * vertex_count_;
+    }
+
+    // Scratch buffers of a single-source search, reused between queries of one thread
+    struct SearchData {
+        using QueueItem = std::pair<Weight, VertexId>;
+
+        std::vector<std::optional<RouteInternalData>> routes;
+        std::vector<VertexId> reached_vertices;
+        std::vector<QueueItem> queue;
+
+        void Reset(size_t vertex_count) {
+            for (const VertexId vertex : reached_vertices) {
+                routes[vertex].reset();
+            }
+            reached_vertices.clear();
+            queue.clear();
+            if (routes.size() < vertex_count) {
+                routes.resize(vertex_count);
+            }
+        }
+    };
+
+    static SearchData& GetThreadSearchData(size_t vertex_count) {
+        thread_local SearchData search_data;
+        search_data.Reset(vertex_count);
+        return search_data;
+    }
+
+    void CheckEdgesWeights(const Graph& graph) const {
+        for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+            if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+        }
+    }
 
     void InitializeRoutesInternalData(const Graph& graph) {
         const size_t vertex_count = graph.GetVertexCount();
+        if (graph.GetEdgeCount() >= NO_EDGE) {
+            throw std::length_error("Too many edges for the route table");
+        }
+        routes_table_.assign(vertex_count * vertex_count, RouteCell{UNREACHABLE_WEIGHT, NO_EDGE});
         for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-            routes_internal_data_[vertex][vertex] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
+            RouteCell* routes_from = GetRouteCells(vertex);
+            routes_from[vertex] = RouteCell{ZERO_WEIGHT, NO_EDGE};
             for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
                 const auto& edge = graph.GetEdge(edge_id);
                 if (edge.weight < ZERO_WEIGHT) {
                     throw std::domain_error("Edges' weights should be non-negative");
                 }
-                auto& route_internal_data = routes_internal_data_[vertex][edge.to];
-                if (!route_internal_data || route_internal_data->weight > edge.weight) {
-                    route_internal_data = RouteInternalData{edge.weight, edge_id};
+                RouteCell& route = routes_from[edge.to];
+                if (edge.weight < route.weight) {
+                    route = RouteCell{edge.weight, static_cast<uint32_t>(edge_id)};
                 }
             }
         }
     }
 
-    void RelaxRoute(VertexId vertex_from, VertexId vertex_to, const RouteInternalData& route_from,
-                    const RouteInternalData& route_to) {
-        auto& route_relaxing = routes_internal_data_[vertex_from][vertex_to];
-        const Weight candidate_weight = route_from.weight + route_to.weight;
-        if (!route_relaxing || candidate_weight < route_relaxing->weight) {
-            route_relaxing = {candidate_weight,
-                              route_to.prev_edge ? route_to.prev_edge : route_from.prev_edge};
+    void RelaxRoutesInternalDataFromVertex(size_t vertex_count, VertexId vertex_from,
+                                           VertexId vertex_through) {
+        RouteCell* routes_from = GetRouteCells(vertex_from);
+        const RouteCell route_from = routes_from[vertex_through];
+        if (route_from.weight == UNREACHABLE_WEIGHT) {
+            return;
+        }
+        const RouteCell* routes_through = GetRouteCells(vertex_through);
+        for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
+            const RouteCell& route_to = routes_through[vertex_to];
+            // An infinite sentinel never wins the comparison below, a finite one could overflow
+            if constexpr (!std::numeric_limits<Weight>::has_infinity) {
+                if (route_to.weight == UNREACHABLE_WEIGHT) {
+                    continue;
+                }
+            }
+            const Weight candidate_weight = route_from.weight + route_to.weight;
+            RouteCell& route_relaxing = routes_from[vertex_to];
+            if (candidate_weight < route_relaxing.weight) {
+                route_relaxing = {candidate_weight,
+                                  route_to.prev_edge != NO_EDGE ? route_to.prev_edge
+                                                                : route_from.prev_edge};
+            }
         }
     }
 
     void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
         for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-            if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through]) {
-                for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-                    if (const auto& route_to = routes_internal_data_[vertex_through][vertex_to]) {
-                        RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
-                    }
+            RelaxRoutesInternalDataFromVertex(vertex_count, vertex_from, vertex_through);
+        }
+    }
+
+    // Rows are relaxed in parallel for each intermediate vertex. The row of the intermediate
+    // vertex itself never changes during its step, so workers only touch their own rows
+    void RelaxRoutesInternalDataInParallel(size_t vertex_count, size_t thread_count) {
+        detail::ThreadBarrier barrier(thread_count);
+        const auto relax_rows = [this, vertex_count, thread_count, &barrier](size_t first_row) {
+            for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
+                for (VertexId vertex_from = first_row; vertex_from < vertex_count;
+                     vertex_from += thread_count) {
+                    RelaxRoutesInternalDataFromVertex(vertex_count, vertex_from, vertex_through);
                 }
+                barrier.Wait();
             }
+        };
+
+        std::vector<std::thread> workers;
+        workers.reserve(thread_count - 1);
+        for (size_t first_row = 1; first_row < thread_count; ++first_row) {
+            workers.emplace_back(relax_rows, first_row);
+        }
+        relax_rows(0);
+        for (auto& worker : workers) {
+            worker.join();
         }
     }
 
+    // Runs task(first, step) on thread_count threads, the calling thread included
+    template <typename Task>
+    static void RunInParallel(size_t thread_count, const Task& task) {
+        std::vector<std::thread> workers;
+        workers.reserve(thread_count - 1);
+        for (size_t first = 1; first < thread_count; ++first) {
+            workers.emplace_back([&task, first, thread_count] {
+                task(first, thread_count);
+            });
+        }
+        task(0, thread_count);
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    void BuildRoutesTable(size_t thread_count);
+    void UpdateRoutesTable(const GraphChange& change, size_t thread_count);
+    // Fills the row of vertex_from with a full single-source search
+    void ComputeRouteCells(VertexId vertex_from);
+    // Lets the rows first_row, first_row + row_step, ... use the edge. The row of the edge
+    // target never changes here, so rows can be relaxed in parallel
+    void RelaxRoutesThroughEdge(EdgeId edge_id, VertexId first_row, size_t row_step);
+
+    std::optional<RouteInfo> BuildPrecomputedRoute(VertexId from, VertexId to) const;
+    std::optional<RouteInfo> SearchRoute(VertexId from, VertexId to) const;
+    // Dijkstra search from vertex from, stops early once is_done returns true for a vertex
+    // whose route is final
+    template <typename IsDone>
+    void Search(SearchData& data, VertexId from, IsDone&& is_done) const;
+
     static constexpr Weight ZERO_WEIGHT{};
     const Graph& graph_;
-    RoutesInternalData routes_internal_data_;
+    RouterMode mode_;
+    size_t vertex_count_ = 0;
+    std::vector<RouteCell> routes_table_;
+    std::unique_ptr<ContractionHierarchy<Weight>> hierarchy_;
 };
 
-template <typename Weight>
-Router<Weight>::Router(const Graph& graph)
+template <typename Weight, typename Graph>
+Router<Weight, Graph>::Router(const Graph& graph, RouterMode mode, size_t thread_count)
     : graph_(graph)
-    , routes_internal_data_(graph.GetVertexCount(),
-                            std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
+    , mode_(mode)
 {
-    InitializeRoutesInternalData(graph);
+    if (mode_ == RouterMode::ON_DEMAND) {
+        CheckEdgesWeights(graph);
+        return;
+    }
+    if (mode_ == RouterMode::CONTRACTION_HIERARCHY) {
+        hierarchy_ = std::make_unique<ContractionHierarchy<Weight>>(graph);
+        return;
+    }
+    BuildRoutesTable(thread_count);
+}
+
+template <typename Weight, typename Graph>
+void Router<Weight, Graph>::BuildRoutesTable(size_t thread_count) {
+    const size_t vertex_count = graph_.GetVertexCount();
+    vertex_count_ = vertex_count;
+    InitializeRoutesInternalData(graph_);
 
-    const size_t vertex_count = graph.GetVertexCount();
+    thread_count = std::min(thread_count, vertex_count);
+    if (thread_count > 1) {
+        RelaxRoutesInternalDataInParallel(vertex_count, thread_count);
+        return;
+    }
     for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
         RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
     }
 }
 
-template <typename Weight>
-std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
-                                                                             VertexId to) const {
-    const auto& route_internal_data = routes_internal_data_.at(from).at(to);
-    if (!route_internal_data) {
+template <typename Weight, typename Graph>
+void Router<Weight, Graph>::Update(const GraphChange& change, size_t thread_count) {
+    if (mode_ == RouterMode::ON_DEMAND) {
+        CheckEdgesWeights(graph_);
+        return;
+    }
+    if (mode_ == RouterMode::CONTRACTION_HIERARCHY) {
+        hierarchy_ = std::make_unique<ContractionHierarchy<Weight>>(graph_);
+        return;
+    }
+    UpdateRoutesTable(change, thread_count);
+}
+
+// Rows that did not use removed edges keep their routes: removals only make routes longer.
+// Other rows and rows of new vertices are searched anew, then every row is relaxed through
+// each added edge in turn, as in an incremental all-pairs update
+template <typename Weight, typename Graph>
+void Router<Weight, Graph>::UpdateRoutesTable(const GraphChange& change, size_t thread_count) {
+    const size_t old_vertex_count = vertex_count_;
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (graph_.GetEdgeCount() >= NO_EDGE) {
+        throw std::length_error("Too many edges for the route table");
+    }
+    CheckEdgesWeights(graph_);
+
+    thread_count = std::max<size_t>(1, std::min(thread_count, vertex_count));
+    // Relaxing through an edge takes O(V^2), so with V added edges the full build is no slower
+    if (change.added_edges.size() >= vertex_count) {
+        BuildRoutesTable(thread_count);
+        return;
+    }
+
+    std::vector<RouteCell> old_table = std::move(routes_table_);
+    routes_table_.assign(vertex_count * vertex_count, RouteCell{UNREACHABLE_WEIGHT, NO_EDGE});
+    vertex_count_ = vertex_count;
+
+    // The shortest route tree of a row consists of the prev_edge of its cells
+    const auto is_edge_removed = [&change](uint32_t edge_id) {
+        return edge_id != NO_EDGE && change.new_edge_ids[edge_id] == GraphChange::REMOVED;
+    };
+    std::vector<bool> is_row_valid(vertex_count, false);
+    for (VertexId old_from = 0; old_from < old_vertex_count; ++old_from) {
+        const VertexId from = change.new_vertex_ids[old_from];
+        const RouteCell* old_routes_from = old_table.data() + old_from * old_vertex_count;
+        if (from == GraphChange::REMOVED
+            || std::any_of(old_routes_from, old_routes_from + old_vertex_count,
+                           [&is_edge_removed](const RouteCell& route) {
+                               return is_edge_removed(route.prev_edge);
+                           })) {
+            continue;
+        }
+
+        RouteCell* routes_from = GetRouteCells(from);
+        for (VertexId old_to = 0; old_to < old_vertex_count; ++old_to) {
+            const VertexId to = change.new_vertex_ids[old_to];
+            if (to == GraphChange::REMOVED) {
+                continue;
+            }
+            const RouteCell& route = old_routes_from[old_to];
+            routes_from[to] = {route.weight,
+                               route.prev_edge != NO_EDGE
+                                   ? static_cast<uint32_t>(change.new_edge_ids[route.prev_edge])
+                                   : NO_EDGE};
+        }
+        is_row_valid[from] = true;
+    }
+    old_table = {};
+
+    std::vector<VertexId> stale_rows;
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        if (!is_row_valid[vertex]) {
+            stale_rows.push_back(vertex);
+        }
+    }
+    RunInParallel(thread_count, [this, &stale_rows](size_t first, size_t step) {
+        for (size_t idx = first; idx < stale_rows.size(); idx += step) {
+            ComputeRouteCells(stale_rows[idx]);
+        }
+    });
+
+    // Each edge must see the rows relaxed through the previous ones
+    detail::ThreadBarrier barrier(thread_count);
+    RunInParallel(thread_count, [this, &change, &barrier](size_t first, size_t step) {
+        for (const EdgeId edge_id : change.added_edges) {
+            RelaxRoutesThroughEdge(edge_id, first, step);
+            barrier.Wait();
+        }
+    });
+}
+
+template <typename Weight, typename Graph>
+void Router<Weight, Graph>::ComputeRouteCells(VertexId vertex_from) {
+    SearchData& data = GetThreadSearchData(vertex_count_);
+    Search(data, vertex_from, [](VertexId) {
+        return false;
+    });
+
+    RouteCell* routes_from = GetRouteCells(vertex_from);
+    std::fill(routes_from, routes_from + vertex_count_, RouteCell{UNREACHABLE_WEIGHT, NO_EDGE});
+    for (const VertexId vertex : data.reached_vertices) {
+        const auto& route = *data.routes[vertex];
+        routes_from[vertex] = {route.weight, route.prev_edge ? static_cast<uint32_t>(*route.prev_edge)
+                                                             : NO_EDGE};
+    }
+}
+
+template <typename Weight, typename Graph>
+void Router<Weight, Graph>::RelaxRoutesThroughEdge(EdgeId edge_id, VertexId first_row,
+                                                   size_t row_step) {
+    const auto edge = graph_.GetEdge(edge_id);
+    const RouteCell* routes_through = GetRouteCells(edge.to);
+    for (VertexId vertex_from = first_row; vertex_from < vertex_count_; vertex_from += row_step) {
+        RouteCell* routes_from = GetRouteCells(vertex_from);
+        if (routes_from[edge.from].weight == UNREACHABLE_WEIGHT) {
+            continue;
+        }
+        const Weight weight_through = routes_from[edge.from].weight + edge.weight;
+        for (VertexId vertex_to = 0; vertex_to < vertex_count_; ++vertex_to) {
+            const RouteCell& route_to = routes_through[vertex_to];
+            if constexpr (!std::numeric_limits<Weight>::has_infinity) {
+                if (route_to.weight == UNREACHABLE_WEIGHT) {
+                    continue;
+                }
+            }
+            const Weight candidate_weight = weight_through + route_to.weight;
+            RouteCell& route_relaxing = routes_from[vertex_to];
+            if (candidate_weight < route_relaxing.weight) {
+                route_relaxing = {candidate_weight,
+                                  route_to.prev_edge != NO_EDGE ? route_to.prev_edge
+                                                                : static_cast<uint32_t>(edge_id)};
+            }
+        }
+    }
+}
+
+template <typename Weight, typename Graph>
+template <typename Archive>
+Router<Weight, Graph>::Router(const Graph& graph, Archive& archive)
+    : graph_(graph)
+    , mode_(archive.template Read<RouterMode>())
+{
+    if (mode_ != RouterMode::ALL_PAIRS && mode_ != RouterMode::ON_DEMAND
+        && mode_ != RouterMode::CONTRACTION_HIERARCHY) {
+        throw std::invalid_argument("Unknown router mode");
+    }
+    if (mode_ == RouterMode::CONTRACTION_HIERARCHY) {
+        hierarchy_ = std::make_unique<ContractionHierarchy<Weight>>(
+            ContractionHierarchy<Weight>::Load(archive));
+        return;
+    }
+    if (mode_ == RouterMode::ALL_PAIRS) {
+        vertex_count_ = graph.GetVertexCount();
+        const auto weights = archive.template ReadVector<Weight>();
+        const auto prev_edges = archive.template ReadVector<uint32_t>();
+        if (weights.size() != vertex_count_ * vertex_count_ || prev_edges.size() != weights.size()) {
+            throw std::invalid_argument("Route table does not match the graph");
+        }
+        routes_table_.resize(weights.size());
+        for (size_t idx = 0; idx < weights.size(); ++idx) {
+            if (prev_edges[idx] != NO_EDGE && prev_edges[idx] >= graph.GetEdgeCount()) {
+                throw std::invalid_argument("Route table does not match the graph");
+            }
+            routes_table_[idx] = RouteCell{weights[idx], prev_edges[idx]};
+        }
+    }
+}
+
+template <typename Weight, typename Graph>
+template <typename Archive>
+void Router<Weight, Graph>::Save(Archive& archive) const {
+    archive.Write(mode_);
+    if (mode_ == RouterMode::CONTRACTION_HIERARCHY) {
+        hierarchy_->Save(archive);
+    } else if (mode_ == RouterMode::ALL_PAIRS) {
+        // Parallel arrays: a cell has padding after prev_edge, whose bytes are unspecified
+        std::vector<Weight> weights;
+        std::vector<uint32_t> prev_edges;
+        weights.reserve(routes_table_.size());
+        prev_edges.reserve(routes_table_.size());
+        for (const RouteCell& cell : routes_table_) {
+            weights.push_back(cell.weight);
+            prev_edges.push_back(cell.prev_edge);
+        }
+        archive.WriteVector(weights);
+        archive.WriteVector(prev_edges);
+    }
+}
+
+template <typename Weight, typename Graph>
+std::optional<typename Router<Weight, Graph>::RouteInfo>
+Router<Weight, Graph>::BuildRoute(VertexId from, VertexId to) const {
+    if (mode_ == RouterMode::ON_DEMAND) {
+        return SearchRoute(from, to);
+    }
+    if (mode_ == RouterMode::CONTRACTION_HIERARCHY) {
+        auto route = hierarchy_->BuildRoute(from, to);
+        if (!route) {
+            return std::nullopt;
+        }
+        return RouteInfo{route->weight, std::move(route->edges)};
+    }
+    return BuildPrecomputedRoute(from, to);
+}
+
+template <typename Weight, typename Graph>
+std::vector<std::optional<Weight>>
+Router<Weight, Graph>::ComputeWeights(const std::vector<VertexId>& sources,
+                                      const std::vector<VertexId>& targets) const {
+    if (mode_ == RouterMode::CONTRACTION_HIERARCHY) {
+        return hierarchy_->ComputeWeights(sources, targets);
+    }
+
+    const size_t vertex_count = graph_.GetVertexCount();
+    const auto is_out_of_range = [vertex_count](VertexId vertex) {
+        return vertex >= vertex_count;
+    };
+    if (std::any_of(sources.begin(), sources.end(), is_out_of_range)
+        || std::any_of(targets.begin(), targets.end(), is_out_of_range)) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    std::vector<std::optional<Weight>> weights(sources.size() * targets.size());
+    if (mode_ == RouterMode::ALL_PAIRS) {
+        for (size_t source_idx = 0; source_idx < sources.size(); ++source_idx) {
+            const RouteCell* routes_from = GetRouteCells(sources[source_idx]);
+            for (size_t target_idx = 0; target_idx < targets.size(); ++target_idx) {
+                const RouteCell& route = routes_from[targets[target_idx]];
+                if (route.weight != UNREACHABLE_WEIGHT) {
+                    weights[source_idx * targets.size() + target_idx] = route.weight;
+                }
+            }
+        }
+        return weights;
+    }
+
+    // The search from a source stops once routes to all distinct targets are final
+    std::vector<bool> is_target(vertex_count, false);
+    size_t distinct_target_count = 0;
+    for (const VertexId target : targets) {
+        if (!is_target[target]) {
+            is_target[target] = true;
+            ++distinct_target_count;
+        }
+    }
+    if (distinct_target_count == 0) {
+        return weights;
+    }
+    for (size_t source_idx = 0; source_idx < sources.size(); ++source_idx) {
+        SearchData& data = GetThreadSearchData(vertex_count);
+        size_t remaining_count = distinct_target_count;
+        Search(data, sources[source_idx], [&is_target, &remaining_count](VertexId vertex) {
+            return is_target[vertex] && --remaining_count == 0;
+        });
+        for (size_t target_idx = 0; target_idx < targets.size(); ++target_idx) {
+            if (const auto& route = data.routes[targets[target_idx]]) {
+                weights[source_idx * targets.size() + target_idx] = route->weight;
+            }
+        }
+    }
+    return weights;
+}
+
+template <typename Weight, typename Graph>
+std::vector<std::pair<VertexId, Weight>>
+Router<Weight, Graph>::ComputeWeightsWithin(VertexId from, Weight max_weight) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    std::vector<std::pair<VertexId, Weight>> weights;
+    if (mode_ == RouterMode::ALL_PAIRS) {
+        const RouteCell* routes_from = GetRouteCells(from);
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            if (routes_from[vertex].weight != UNREACHABLE_WEIGHT
+                && !(max_weight < routes_from[vertex].weight)) {
+                weights.emplace_back(vertex, routes_from[vertex].weight);
+            }
+        }
+        return weights;
+    }
+
+    // The hierarchy only answers point-to-point queries, the bounded search runs on the graph
+    SearchData& data = GetThreadSearchData(vertex_count);
+    Search(data, from, [&data, max_weight](VertexId vertex) {
+        return max_weight < data.routes[vertex]->weight;
+    });
+    // A reached vertex within the bound was settled before the search stopped
+    for (const VertexId vertex : data.reached_vertices) {
+        const Weight weight = data.routes[vertex]->weight;
+        if (!(max_weight < weight)) {
+            weights.emplace_back(vertex, weight);
+        }
+    }
+    return weights;
+}
+
+template <typename Weight, typename Graph>
+std::optional<typename Router<Weight, Graph>::RouteInfo>
+Router<Weight, Graph>::BuildPrecomputedRoute(VertexId from, VertexId to) const {
+    if (from >= vertex_count_ || to >= vertex_count_) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    const RouteCell* routes_from = GetRouteCells(from);
+    if (routes_from[to].weight == UNREACHABLE_WEIGHT) {
+        return std::nullopt;
+    }
+    const Weight weight = routes_from[to].weight;
+    std::vector<EdgeId> edges;
+    for (uint32_t edge_id = routes_from[to].prev_edge;
+         edge_id != NO_EDGE;
+         edge_id = routes_from[graph_.GetEdge(edge_id).from].prev_edge)
+    {
+        edges.push_back(edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    return RouteInfo{weight, std::move(edges)};
+}
+
+template <typename Weight, typename Graph>
+std::optional<typename Router<Weight, Graph>::RouteInfo>
+Router<Weight, Graph>::SearchRoute(VertexId from, VertexId to) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    SearchData& data = GetThreadSearchData(vertex_count);
+    Search(data, from, [to](VertexId vertex) {
+        return vertex == to;
+    });
+    const auto& routes = data.routes;
+
+    if (!routes[to]) {
         return std::nullopt;
     }
-    const Weight weight = route_internal_data->weight;
+
     std::vector<EdgeId> edges;
-    for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
+    for (std::optional<EdgeId> edge_id = routes[to]->prev_edge;
          edge_id;
-         edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
+         edge_id = routes[graph_.GetEdge(*edge_id).from]->prev_edge)
     {
         edges.push_back(*edge_id);
     }
     std::reverse(edges.begin(), edges.end());
 
-    return RouteInfo{weight, std::move(edges)};
+    return RouteInfo{routes[to]->weight, std::move(edges)};
+}
+
+template <typename Weight, typename Graph>
+template <typename IsDone>
+void Router<Weight, Graph>::Search(SearchData& data, VertexId from, IsDone&& is_done) const {
+    auto& routes = data.routes;
+    auto& queue = data.queue;
+    const auto queue_compare = std::greater<typename SearchData::QueueItem>{};
+
+    routes[from] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
+    data.reached_vertices.push_back(from);
+    queue.emplace_back(ZERO_WEIGHT, from);
+
+    while (!queue.empty()) {
+        std::pop_heap(queue.begin(), queue.end(), queue_compare);
+        const auto [weight, vertex] = queue.back();
+        queue.pop_back();
+
+        if (routes[vertex]->weight < weight) {
+            continue;
+        }
+        if (is_done(vertex)) {
+            return;
+        }
+
+        for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+            const auto& edge = graph_.GetEdge(edge_id);
+            const Weight candidate_weight = weight + edge.weight;
+            auto& route_to = routes[edge.to];
+            if (!route_to) {
+                data.reached_vertices.push_back(edge.to);
+            } else if (!(candidate_weight < route_to->weight)) {
+                continue;
+            }
+            route_to = RouteInternalData{candidate_weight, edge_id};
+            queue.emplace_back(candidate_weight, edge.to);
+            std::push_heap(queue.begin(), queue.end(), queue_compare);
+        }
+    }
 }
 
 }  // namespace graph
\ No newline at end of file
@@ -0,0 +1,383 @@
+#include "serialization.h"
+
+#include <fstream>
+#include <variant>
+
+#ifdef _WIN32
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace serialization {
+
+namespace {
+
+// Заголовок файла: сигнатура и версия формата
+constexpr uint64_t FILE_SIGNATURE = 0x45534142'4F505254;  // "TRPOBASE"
+constexpr uint32_t FORMAT_VERSION = 5;
+
+void SaveColor(OutputArchive& archive, const svg::Color& color) {
+    archive.Write(static_cast<uint8_t>(color.index()));
+    if (const auto* name = std::get_if<std::string>(&color)) {
+        archive.WriteString(*name);
+    }
+    else if (const auto* rgb = std::get_if<svg::Rgb>(&color)) {
+        archive.Write(*rgb);
+    }
+    else if (const auto* rgba = std::get_if<svg::Rgba>(&color)) {
+        // Поля по отдельности: между blue и opacity есть байты выравнивания
+        archive.Write(rgba->red);
+        archive.Write(rgba->green);
+        archive.Write(rgba->blue);
+        archive.Write(rgba->opacity);
+    }
+}
+
+void SavePoint(OutputArchive& archive, svg::Point point) {
+    archive.Write(point.x);
+    archive.Write(point.y);
+}
+
+svg::Point LoadPoint(InputArchive& archive) {
+    const double x = archive.Read<double>();
+    return { x, archive.Read<double>() };
+}
+
+svg::Color LoadColor(InputArchive& archive) {
+    switch (archive.Read<uint8_t>()) {
+    case 0:
+        return svg::NoneColor;
+    case 1:
+        return std::string(archive.ReadString());
+    case 2:
+        return archive.Read<svg::Rgb>();
+    case 3: {
+        const auto red = archive.Read<uint8_t>();
+        const auto green = archive.Read<uint8_t>();
+        const auto blue = archive.Read<uint8_t>();
+        return svg::Rgba(red, green, blue, archive.Read<double>());
+    }
+    default:
+        throw FormatError("Unknown color type");
+    }
+}
+
+void SaveRenderSettings(OutputArchive& archive, const renderer::RenderSettings& settings) {
+    archive.Write(settings.width);
+    archive.Write(settings.height);
+    archive.Write(settings.padding);
+    archive.Write(settings.line_width);
+    archive.Write(settings.stop_radius);
+    archive.Write(settings.bus_label_font_size);
+    SavePoint(archive, settings.bus_label_offset);
+    archive.Write(settings.stop_label_font_size);
+    SavePoint(archive, settings.stop_label_offset);
+    SaveColor(archive, settings.underlayer_color);
+    archive.Write(settings.underlayer_width);
+    archive.Write(static_cast<uint64_t>(settings.color_palette.size()));
+    for (const auto& color : settings.color_palette) {
+        SaveColor(archive, color);
+    }
+    archive.WriteString(settings.stop_label_font_family);
+    archive.WriteString(settings.bus_label_font_family);
+    SaveColor(archive, settings.stop_label_color);
+}
+
+renderer::RenderSettings LoadRenderSettings(InputArchive& archive) {
+    renderer::RenderSettings settings;
+    settings.width = archive.Read<double>();
+    settings.height = archive.Read<double>();
+    settings.padding = archive.Read<double>();
+    settings.line_width = archive.Read<double>();
+    settings.stop_radius = archive.Read<double>();
+    settings.bus_label_font_size = archive.Read<int>();
+    settings.bus_label_offset = LoadPoint(archive);
+    settings.stop_label_font_size = archive.Read<int>();
+    settings.stop_label_offset = LoadPoint(archive);
+    settings.underlayer_color = LoadColor(archive);
+    settings.underlayer_width = archive.Read<double>();
+    settings.color_palette.resize(archive.Read<uint64_t>());
+    for (auto& color : settings.color_palette) {
+        color = LoadColor(archive);
+    }
+    settings.stop_label_font_family = archive.ReadString();
+    settings.bus_label_font_family = archive.ReadString();
+    settings.stop_label_color = LoadColor(archive);
+    return settings;
+}
+
+void SaveStopIds(OutputArchive& archive, const CatalogueIndex& index,
+                 const std::vector<transport::detail::Stop*>& stops) {
+    archive.Write(static_cast<uint64_t>(stops.size()));
+    for (const auto* stop : stops) {
+        archive.Write(index.GetStopId(stop));
+    }
+}
+
+std::vector<transport::detail::Stop*> LoadStops(InputArchive& archive, const CatalogueIndex& index) {
+    std::vector<transport::detail::Stop*> stops(archive.Read<uint64_t>());
+    for (auto& stop : stops) {
+        stop = index.GetStop(archive.Read<uint32_t>());
+    }
+    return stops;
+}
+
+// Расстояния сохраняются до автобусов: по ним считается длина маршрутов
+void SaveCatalogue(OutputArchive& archive, const transport::Catalogue& catalogue,
+                   const CatalogueIndex& index) {
+    const auto& stops = catalogue.GetStops();
+    archive.Write(static_cast<uint64_t>(stops.size()));
+    for (const auto& stop : stops) {
+        archive.WriteString(stop.name);
+        archive.Write(stop.coordinates.lat);
+        archive.Write(stop.coordinates.lng);
+    }
+
+    const auto& distances = catalogue.GetDistances();
+    archive.Write(static_cast<uint64_t>(distances.GetSize()));
+    distances.ForEach([&archive](transport::detail::StopId from, transport::detail::StopId to, double distance) {
+        archive.Write(from);
+        archive.Write(to);
+        archive.Write(distance);
+    });
+
+    const auto& buses = catalogue.GetBuses();
+    archive.Write(static_cast<uint64_t>(buses.size()));
+    for (const auto& bus : buses) {
+        archive.WriteString(bus.name);
+        archive.Write(bus.is_roundtrip);
+        archive.Write(bus.is_removed);
+        SaveStopIds(archive, index, bus.stops);
+        SaveStopIds(archive, index, bus.final_stops);
+        archive.WriteVector(bus.departures);
+    }
+}
+
+void LoadCatalogue(InputArchive& archive, transport::Catalogue& catalogue) {
+    const auto stop_count = archive.Read<uint64_t>();
+    for (uint64_t i = 0; i < stop_count; ++i) {
+        std::string name(archive.ReadString());
+        const double lat = archive.Read<double>();
+        const double lng = archive.Read<double>();
+        catalogue.AddStop({ std::move(name), lat, lng });
+    }
+
+    // Автобусов ещё нет, индекс нужен только для остановок
+    const CatalogueIndex stops_index(catalogue);
+    const auto distance_count = archive.Read<uint64_t>();
+    for (uint64_t i = 0; i < distance_count; ++i) {
+        auto* from = stops_index.GetStop(archive.Read<uint32_t>());
+        auto* to = stops_index.GetStop(archive.Read<uint32_t>());
+        catalogue.SetDistance({ from, to }, archive.Read<double>());
+    }
+
+    const auto bus_count = archive.Read<uint64_t>();
+    for (uint64_t i = 0; i < bus_count; ++i) {
+        std::string name(archive.ReadString());
+        const bool is_roundtrip = archive.Read<bool>();
+        const bool is_removed = archive.Read<bool>();
+        auto stops = LoadStops(archive, stops_index);
+        auto final_stops = LoadStops(archive, stops_index);
+        transport::detail::bus::Bus bus_data{ std::move(name), std::move(stops), std::move(final_stops), is_roundtrip };
+        bus_data.departures = archive.ReadVector<double>();
+        auto* bus = catalogue.AddBus(std::move(bus_data));
+        // Удалённые автобусы хранятся, чтобы номера остальных совпадали с номерами в маршрутизаторе
+        if (is_removed) {
+            catalogue.RemoveBus(bus);
+        }
+    }
+}
+
+} // namespace
+
+OutputArchive::OutputArchive(std::ostream& out)
+    : out_(out) {
+}
+
+void OutputArchive::WriteString(std::string_view str) {
+    Write(static_cast<uint64_t>(str.size()));
+    out_.write(str.data(), str.size());
+}
+
+InputArchive::InputArchive(std::string_view data)
+    : data_(data) {
+}
+
+std::string_view InputArchive::ReadString() {
+    const auto size = Read<uint64_t>();
+    return { Take(size), size };
+}
+
+const char* InputArchive::Take(size_t size) {
+    if (size > data_.size()) {
+        throw FormatError("Unexpected end of data");
+    }
+    const char* data = data_.data();
+    data_.remove_prefix(size);
+    return data;
+}
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Cannot open " + path.string());
+    }
+    buffer_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+}
+
+MappedFile::~MappedFile() = default;
+
+#else
+
+MappedFile::MappedFile(const std::filesystem::path& path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open " + path.string());
+    }
+    struct stat file_stat {};
+    if (fstat(fd, &file_stat) != 0) {
+        close(fd);
+        throw std::runtime_error("Cannot stat " + path.string());
+    }
+    size_ = static_cast<size_t>(file_stat.st_size);
+    if (size_ > 0) {
+        void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("Cannot map " + path.string());
+        }
+        data_ = static_cast<const char*>(data);
+    }
+    // Отображение остаётся действительным и после закрытия дескриптора
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (data_ != nullptr) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+}
+
+#endif
+
+std::string_view MappedFile::GetData() const {
+    return { data_, size_ };
+}
+
+CatalogueIndex::CatalogueIndex(const transport::Catalogue& catalogue) {
+    for (const auto& stop : catalogue.GetStops()) {
+        stops_.push_back(catalogue.GetStop(stop.id));
+    }
+    for (const auto& bus : catalogue.GetBuses()) {
+        buses_.push_back(catalogue.GetBus(bus.id));
+    }
+}
+
+uint32_t CatalogueIndex::GetStopId(const transport::detail::Stop* stop) const {
+    return stop->id;
+}
+
+uint32_t CatalogueIndex::GetBusId(const transport::detail::bus::Bus* bus) const {
+    return bus->id;
+}
+
+transport::detail::Stop* CatalogueIndex::GetStop(uint32_t id) const {
+    if (id >= stops_.size()) {
+        throw FormatError("Stop id is out of range");
+    }
+    return stops_[id];
+}
+
+transport::detail::bus::Bus* CatalogueIndex::GetBus(uint32_t id) const {
+    if (id >= buses_.size()) {
+        throw FormatError("Bus id is out of range");
+    }
+    return buses_[id];
+}
+
+void SaveTransportBase(const std::filesystem::path& path,
+                       const transport::Catalogue& catalogue,
+                       const renderer::RenderSettings& render_settings,
+                       const transport::router::TransportRouter& router) {
+    // Файл собирается рядом и подменяет старый переименованием: кто читает базу
+    // в это время, видит её целиком старой или целиком новой
+    auto temp_path = path;
+    temp_path += ".tmp";
+    std::ofstream out(temp_path, std::ios::binary);
+    if (!out) {
+        throw std::runtime_error("Cannot create " + temp_path.string());
+    }
+
+    OutputArchive archive(out);
+    archive.Write(FILE_SIGNATURE);
+    archive.Write(FORMAT_VERSION);
+
+    const CatalogueIndex index(catalogue);
+    SaveCatalogue(archive, catalogue, index);
+    SaveRenderSettings(archive, render_settings);
+    router.Save(archive, index);
+
+    out.close();
+    if (!out) {
+        throw std::runtime_error("Cannot write " + temp_path.string());
+    }
+    std::filesystem::rename(temp_path, path);
+}
+
+TransportBase::TransportBase(const std::filesystem::path& path) {
+    const MappedFile file(path);
+    InputArchive archive(file.GetData());
+
+    if (archive.Read<uint64_t>() != FILE_SIGNATURE) {
+        throw FormatError(path.string() + " is not a transport base");
+    }
+    if (archive.Read<uint32_t>() != FORMAT_VERSION) {
+        throw FormatError(path.string() + " has unsupported format version");
+    }
+
+    LoadCatalogue(archive, catalogue_);
+    const CatalogueIndex index(catalogue_);
+
+    std::vector<transport::detail::bus::Bus*> buses;
+    for (uint32_t id = 0; id < catalogue_.GetBuses().size(); ++id) {
+        buses.push_back(index.GetBus(id));
+    }
+    renderer_ = renderer::MapRenderer(LoadRenderSettings(archive), buses);
+    router_.emplace(archive, index);
+}
+
+void TransportBase::Update() {
+    const CatalogueIndex index(catalogue_);
+    std::vector<transport::detail::bus::Bus*> buses;
+    for (uint32_t id = 0; id < catalogue_.GetBuses().size(); ++id) {
+        buses.push_back(index.GetBus(id));
+    }
+    renderer_ = renderer::MapRenderer(renderer_.GetSettings(), buses);
+    router_->Update(catalogue_);
+}
+
+void TransportBase::Save(const std::filesystem::path& path) const {
+    SaveTransportBase(path, catalogue_, renderer_.GetSettings(), *router_);
+}
+
+transport::Catalogue& TransportBase::GetCatalogue() {
+    return catalogue_;
+}
+
+const renderer::MapRenderer& TransportBase::GetRenderer() const {
+    return renderer_;
+}
+
+const transport::router::TransportRouter& TransportBase::GetRouter() const {
+    return *router_;
+}
+
+} // end namespace serialization
@@ -0,0 +1,164 @@
+#pragma once
+
+#include "map_renderer.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace serialization {
+
+struct SerializationSettings {
+    std::filesystem::path file;
+};
+
+// Файл базы повреждён или записан другой версией программы
+class FormatError : public std::runtime_error {
+public:
+    using runtime_error::runtime_error;
+};
+
+// Значения типа пишутся байт в байт без байтов выравнивания, иначе содержимое файла
+// зависит от раскладки структуры компилятором. Числа с плавающей точкой имеют несколько
+// представлений одного значения, но выравнивания в них нет
+template <typename T>
+inline constexpr bool IS_PADDING_FREE = std::is_scalar_v<T> || std::has_unique_object_representations_v<T>;
+
+// Пишет значения в двоичный поток в их представлении в памяти
+class OutputArchive {
+public:
+    explicit OutputArchive(std::ostream& out);
+
+    template <typename T>
+    void Write(const T& value) {
+        static_assert(std::is_trivially_copyable_v<T> && IS_PADDING_FREE<T>);
+        out_.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    void WriteVector(const std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable_v<T> && IS_PADDING_FREE<T>);
+        Write(static_cast<uint64_t>(values.size()));
+        out_.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+    }
+
+    void WriteString(std::string_view str);
+
+private:
+    std::ostream& out_;
+};
+
+// Читает значения, записанные OutputArchive, из буфера в памяти
+class InputArchive {
+public:
+    explicit InputArchive(std::string_view data);
+
+    template <typename T>
+    T Read() {
+        static_assert(std::is_trivially_copyable_v<T>);
+        if constexpr (std::is_same_v<T, bool>) {
+            // Байт, отличный от 0 и 1, не является значением bool
+            const auto byte = Read<uint8_t>();
+            if (byte > 1) {
+                throw FormatError("Invalid bool value");
+            }
+            return byte == 1;
+        } else {
+            T value;
+            std::memcpy(&value, Take(sizeof(T)), sizeof(T));
+            return value;
+        }
+    }
+
+    template <typename T>
+    std::vector<T> ReadVector() {
+        static_assert(std::is_trivially_copyable_v<T>);
+        const auto size = Read<uint64_t>();
+        if (size > data_.size() / sizeof(T)) {
+            throw FormatError("Unexpected end of data");
+        }
+        std::vector<T> values(size);
+        std::memcpy(values.data(), Take(size * sizeof(T)), size * sizeof(T));
+        return values;
+    }
+
+    std::string_view ReadString();
+
+private:
+    const char* Take(size_t size);
+
+    std::string_view data_;
+};
+
+// Файл, отображённый в память только для чтения
+class MappedFile {
+public:
+    explicit MappedFile(const std::filesystem::path& path);
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    std::string_view GetData() const;
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    // Без mmap файл читается в память целиком
+    std::string buffer_;
+#endif
+};
+
+// Номера остановок и автобусов в порядке их хранения в каталоге, они же id в каталоге
+class CatalogueIndex {
+public:
+    explicit CatalogueIndex(const transport::Catalogue& catalogue);
+
+    uint32_t GetStopId(const transport::detail::Stop* stop) const;
+    uint32_t GetBusId(const transport::detail::bus::Bus* bus) const;
+    transport::detail::Stop* GetStop(uint32_t id) const;
+    transport::detail::bus::Bus* GetBus(uint32_t id) const;
+
+private:
+    std::vector<transport::detail::Stop*> stops_;
+    std::vector<transport::detail::bus::Bus*> buses_;
+};
+
+// Сохраняет каталог, настройки и построенный маршрутизатор в файл
+void SaveTransportBase(const std::filesystem::path& path,
+                       const transport::Catalogue& catalogue,
+                       const renderer::RenderSettings& render_settings,
+                       const transport::router::TransportRouter& router);
+
+// База, загруженная из файла. Граф и таблицы маршрутизатора при загрузке не перестраиваются
+class TransportBase {
+public:
+    explicit TransportBase(const std::filesystem::path& path);
+    TransportBase(const TransportBase&) = delete;
+    TransportBase& operator=(const TransportBase&) = delete;
+
+    transport::Catalogue& GetCatalogue();
+    const renderer::MapRenderer& GetRenderer() const;
+    const transport::router::TransportRouter& GetRouter() const;
+
+    // Догоняет каталог, изменённый через GetCatalogue: карта строится заново,
+    // маршрутизатор исправляет только то, что затронули изменения
+    void Update();
+    void Save(const std::filesystem::path& path) const;
+
+private:
+    transport::Catalogue catalogue_;
+    renderer::MapRenderer renderer_;
+    std::optional<transport::router::TransportRouter> router_;
+};
+
+} // end namespace serialization
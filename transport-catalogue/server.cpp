@@ -0,0 +1,330 @@
+#include "server.h"
+#include "json_builder.h"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace server {
+
+namespace {
+
+json::Node MakeErrorResponse(std::string message) {
+    using namespace std::string_literals;
+    return json::Builder{}.StartDict().Key("error_message"s).Value(std::move(message)).EndDict().Build();
+}
+
+// Ответ печатается одной строкой
+void AppendResponse(json::Node response, std::string& output) {
+    std::ostringstream stream;
+    json::PrintCompact(json::Document(std::move(response)), stream);
+    output += stream.str();
+    output += '\n';
+}
+
+} // namespace
+
+#ifdef _WIN32
+
+QueryServer::QueryServer(ServerSettings settings, QueryProcessor processor)
+    : settings_(std::move(settings))
+    , processor_(std::move(processor)) {
+    throw std::runtime_error("Query server requires POSIX sockets");
+}
+
+QueryServer::~QueryServer() = default;
+
+void QueryServer::Run() {
+}
+
+void QueryServer::Stop() {
+}
+
+#else
+
+namespace {
+
+// Строка запроса длиннее этого считается ошибкой клиента
+constexpr size_t MAX_LINE_SIZE = 16 << 20;
+// Пока неотправленных ответов больше, новые запросы соединения не читаются
+constexpr size_t MAX_PENDING_OUTPUT = 64 << 20;
+constexpr size_t READ_CHUNK_SIZE = 64 << 10;
+
+#ifdef MSG_NOSIGNAL
+constexpr int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+constexpr int SEND_FLAGS = 0;
+#endif
+
+[[noreturn]] void ThrowSystemError(const char* what) {
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+void SetNonBlocking(int fd) {
+    const int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        ThrowSystemError("fcntl");
+    }
+}
+
+bool IsRetryable(int error) {
+    return error == EAGAIN || error == EWOULDBLOCK || error == EINTR;
+}
+
+void CloseFd(int& fd) {
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+}
+
+} // namespace
+
+QueryServer::QueryServer(ServerSettings settings, QueryProcessor processor)
+    : settings_(std::move(settings))
+    , processor_(std::move(processor)) {
+    if (pipe(wakeup_fds_) != 0) {
+        ThrowSystemError("pipe");
+    }
+    try {
+        SetNonBlocking(wakeup_fds_[0]);
+        SetNonBlocking(wakeup_fds_[1]);
+        Listen();
+    }
+    catch (...) {
+        CloseFd(listen_fd_);
+        CloseFd(wakeup_fds_[0]);
+        CloseFd(wakeup_fds_[1]);
+        throw;
+    }
+}
+
+QueryServer::~QueryServer() {
+    for (auto& connection : connections_) {
+        CloseFd(connection.fd);
+    }
+    CloseFd(listen_fd_);
+    CloseFd(wakeup_fds_[0]);
+    CloseFd(wakeup_fds_[1]);
+    if (!settings_.unix_socket.empty()) {
+        unlink(settings_.unix_socket.c_str());
+    }
+}
+
+void QueryServer::Listen() {
+    if (!settings_.unix_socket.empty()) {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (settings_.unix_socket.size() >= sizeof(address.sun_path)) {
+            throw std::invalid_argument("Unix socket path is too long");
+        }
+        std::memcpy(address.sun_path, settings_.unix_socket.data(), settings_.unix_socket.size());
+
+        listen_fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listen_fd_ < 0) {
+            ThrowSystemError("socket");
+        }
+        // Файл сокета мог остаться от прошлого запуска
+        unlink(settings_.unix_socket.c_str());
+        if (bind(listen_fd_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+            ThrowSystemError("bind");
+        }
+    }
+    else {
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(settings_.port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        if (listen_fd_ < 0) {
+            ThrowSystemError("socket");
+        }
+        const int reuse = 1;
+        setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        if (bind(listen_fd_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+            ThrowSystemError("bind");
+        }
+    }
+
+    if (listen(listen_fd_, SOMAXCONN) != 0) {
+        ThrowSystemError("listen");
+    }
+    SetNonBlocking(listen_fd_);
+}
+
+void QueryServer::Run() {
+    // Первые два элемента - слушающий сокет и канал остановки, дальше соединения по порядку
+    std::vector<pollfd> poll_fds;
+
+    while (!is_stopped_) {
+        poll_fds.clear();
+        poll_fds.push_back({ listen_fd_, POLLIN, 0 });
+        poll_fds.push_back({ wakeup_fds_[0], POLLIN, 0 });
+        for (const auto& connection : connections_) {
+            short events = 0;
+            if (!connection.is_input_closed && connection.output.size() - connection.output_offset < MAX_PENDING_OUTPUT) {
+                events |= POLLIN;
+            }
+            if (!connection.output.empty()) {
+                events |= POLLOUT;
+            }
+            poll_fds.push_back({ connection.fd, events, 0 });
+        }
+
+        if (poll(poll_fds.data(), poll_fds.size(), -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ThrowSystemError("poll");
+        }
+
+        for (size_t idx = 0; idx < connections_.size(); ++idx) {
+            auto& connection = connections_[idx];
+            const short revents = poll_fds[idx + 2].revents;
+
+            bool is_open = true;
+            if (revents & (POLLIN | POLLHUP | POLLERR)) {
+                is_open = ReadRequests(connection);
+            }
+            // Ответы отправляются сразу, не дожидаясь следующего витка
+            if (is_open && !connection.output.empty()) {
+                is_open = WriteResponses(connection);
+            }
+            if (!is_open || (connection.is_input_closed && connection.output.empty())) {
+                CloseFd(connection.fd);
+            }
+        }
+        connections_.erase(std::remove_if(connections_.begin(), connections_.end(),
+            [](const Connection& connection) {
+                return connection.fd < 0;
+            }), connections_.end());
+
+        if (poll_fds[0].revents & POLLIN) {
+            AcceptConnections();
+        }
+        if (poll_fds[1].revents & POLLIN) {
+            char buffer[64];
+            while (read(wakeup_fds_[0], buffer, sizeof(buffer)) > 0) {
+            }
+        }
+    }
+}
+
+void QueryServer::Stop() {
+    is_stopped_ = true;
+    const char byte = 0;
+    [[maybe_unused]] const auto written = write(wakeup_fds_[1], &byte, 1);
+}
+
+void QueryServer::AcceptConnections() {
+    while (true) {
+        const int fd = accept(listen_fd_, nullptr, nullptr);
+        if (fd < 0) {
+            // Очередь пуста или кончились дескрипторы: остальные подождут следующего витка
+            return;
+        }
+        try {
+            SetNonBlocking(fd);
+        }
+        catch (const std::system_error&) {
+            close(fd);
+            continue;
+        }
+        connections_.emplace_back(fd);
+    }
+}
+
+bool QueryServer::ReadRequests(Connection& connection) {
+    char buffer[READ_CHUNK_SIZE];
+    const ssize_t size = read(connection.fd, buffer, sizeof(buffer));
+    if (size < 0) {
+        return IsRetryable(errno);
+    }
+    if (size == 0) {
+        // Последняя строка может быть без перевода строки
+        connection.is_input_closed = true;
+        ProcessLine(connection.input, connection.output);
+        connection.input.clear();
+        return true;
+    }
+
+    // Полные строки уже обработаны, поэтому в старой части буфера перевода строки нет
+    size_t search_from = connection.input.size();
+    connection.input.append(buffer, static_cast<size_t>(size));
+
+    const std::string_view input = connection.input;
+    size_t line_begin = 0;
+    for (size_t line_end; (line_end = input.find('\n', search_from)) != std::string_view::npos;) {
+        ProcessLine(input.substr(line_begin, line_end - line_begin), connection.output);
+        line_begin = search_from = line_end + 1;
+    }
+    connection.input.erase(0, line_begin);
+
+    if (connection.input.size() > MAX_LINE_SIZE) {
+        connection.input.clear();
+        connection.is_input_closed = true;
+        AppendResponse(MakeErrorResponse("Request line is too long"), connection.output);
+    }
+    return true;
+}
+
+// Пустой output означает, что неотправленных ответов нет
+bool QueryServer::WriteResponses(Connection& connection) {
+    std::string& output = connection.output;
+    while (connection.output_offset < output.size()) {
+        const ssize_t size = send(connection.fd, output.data() + connection.output_offset,
+                                  output.size() - connection.output_offset, SEND_FLAGS);
+        if (size < 0) {
+            // Сдвиг остатка окупается: он не короче уже отправленной части
+            if (connection.output_offset > output.size() / 2) {
+                output.erase(0, connection.output_offset);
+                connection.output_offset = 0;
+            }
+            return IsRetryable(errno);
+        }
+        connection.output_offset += static_cast<size_t>(size);
+    }
+    output.clear();
+    connection.output_offset = 0;
+    return true;
+}
+
+#endif
+
+// Ответ на строку, которую не удалось разобрать или обработать, - словарь с error_message
+void QueryServer::ProcessLine(std::string_view line, std::string& output) const {
+    while (!line.empty() && (line.back() == '\r' || line.back() == ' ' || line.back() == '\t')) {
+        line.remove_suffix(1);
+    }
+    if (line.empty()) {
+        return;
+    }
+
+    json::Node response;
+    try {
+        const auto request = json::Load(line);
+        response = processor_(request.GetRoot().AsDict());
+    }
+    catch (const std::exception& error) {
+        response = MakeErrorResponse(error.what());
+    }
+
+    AppendResponse(std::move(response), output);
+}
+
+} // end namespace server
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "json.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace server {
+
+struct ServerSettings {
+    // Путь к Unix-сокету. Если пуст, сервер слушает порт port на 127.0.0.1
+    std::string unix_socket;
+    uint16_t port = 0;
+};
+
+// Отвечает на один запрос из stat_requests
+using QueryProcessor = std::function<json::Node(const json::Dict& request)>;
+
+// Сервер запросов к построенной базе. Клиент присылает запросы по одному JSON-словарю
+// на строку и получает ответ на каждый одной строкой компактного JSON в том же порядке.
+// Все соединения обслуживает один цикл poll, данные базы только читаются
+class QueryServer {
+public:
+    // Сразу начинает слушать сокет, ошибки настройки сокета выбрасываются отсюда
+    QueryServer(ServerSettings settings, QueryProcessor processor);
+    QueryServer(const QueryServer&) = delete;
+    QueryServer& operator=(const QueryServer&) = delete;
+    ~QueryServer();
+
+    // Обслуживает соединения до вызова Stop
+    void Run();
+    // Можно вызывать из другого потока и из обработчика сигнала
+    void Stop();
+
+private:
+    struct Connection {
+        explicit Connection(int fd)
+            : fd(fd) {
+        }
+
+        int fd = -1;
+        std::string input;
+        // Ответы с output_offset ещё не отправлены. Отправленная часть удаляется, когда
+        // отправлено всё или больше половины буфера, а не после каждого send
+        std::string output;
+        size_t output_offset = 0;
+        // Клиент закрыл свою сторону: соединение закрывается после отправки ответов
+        bool is_input_closed = false;
+    };
+
+    void Listen();
+    void AcceptConnections();
+    // Возвращают false, если соединение нужно закрыть
+    bool ReadRequests(Connection& connection);
+    bool WriteResponses(Connection& connection);
+    void ProcessLine(std::string_view line, std::string& output) const;
+
+    ServerSettings settings_;
+    QueryProcessor processor_;
+    std::atomic<bool> is_stopped_{ false };
+    int listen_fd_ = -1;
+    // Канал, запись в который будит цикл poll при остановке
+    int wakeup_fds_[2] = { -1, -1 };
+    std::vector<Connection> connections_;
+};
+
+} // end namespace server
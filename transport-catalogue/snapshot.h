@@ -0,0 +1,161 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace server {
+
+// Версии неизменяемых данных, которые читаются без блокировок (схема RCU с эпохами).
+// Писатель публикует новую версию атомарной заменой указателя. Снятая версия удаляется,
+// когда из неё вышли все читатели, успевшие её взять: читатель отмечает в своём слоте
+// эпоху, в которой начал чтение, а писатель удаляет версии, снятые раньше всех отметок.
+// Каждый читающий поток работает через собственный Reader
+template <typename T>
+class SnapshotHolder {
+    struct Slot;
+
+public:
+    // Версия, которую читатель держит, пока жив этот объект
+    class Snapshot {
+    public:
+        Snapshot(const Snapshot&) = delete;
+        Snapshot& operator=(const Snapshot&) = delete;
+        ~Snapshot() {
+            slot_.epoch.store(IDLE, std::memory_order_release);
+        }
+
+        const T& operator*() const {
+            return *version_;
+        }
+        const T* operator->() const {
+            return version_;
+        }
+
+    private:
+        friend class SnapshotHolder;
+
+        Snapshot(Slot& slot, const T* version)
+            : slot_(slot)
+            , version_(version) {
+        }
+
+        Slot& slot_;
+        const T* version_;
+    };
+
+    // Слот читающего потока. Одновременно через него можно держать только один Snapshot
+    class Reader {
+    public:
+        Reader(Reader&& other) noexcept
+            : holder_(std::exchange(other.holder_, nullptr))
+            , slot_(other.slot_) {
+        }
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+        ~Reader() {
+            if (holder_ != nullptr) {
+                slot_->is_taken.store(false, std::memory_order_release);
+            }
+        }
+
+        // Берёт текущую версию. Не блокируется и не ждёт писателя
+        Snapshot Lock() const {
+            slot_->epoch.store(holder_->epoch_.load());
+            return Snapshot(*slot_, holder_->current_.load());
+        }
+
+    private:
+        friend class SnapshotHolder;
+
+        Reader(const SnapshotHolder& holder, Slot& slot)
+            : holder_(&holder)
+            , slot_(&slot) {
+        }
+
+        const SnapshotHolder* holder_;
+        Slot* slot_;
+    };
+
+    explicit SnapshotHolder(std::unique_ptr<T> version, size_t max_readers = 64)
+        : current_(version.release())
+        , slots_(new Slot[max_readers])
+        , slot_count_(max_readers) {
+    }
+    SnapshotHolder(const SnapshotHolder&) = delete;
+    SnapshotHolder& operator=(const SnapshotHolder&) = delete;
+    // Все Reader должны быть уничтожены раньше
+    ~SnapshotHolder() {
+        delete current_.load();
+    }
+
+    // Выбрасывает std::length_error, если все слоты заняты
+    Reader MakeReader() const {
+        for (size_t idx = 0; idx < slot_count_; ++idx) {
+            bool is_taken = false;
+            if (slots_[idx].is_taken.compare_exchange_strong(is_taken, true, std::memory_order_acquire)) {
+                return Reader(*this, slots_[idx]);
+            }
+        }
+        throw std::length_error("Too many snapshot readers");
+    }
+
+    // Делает version текущей. Читатели, взявшие прежнюю версию, дочитывают её
+    void Publish(std::unique_ptr<T> version) {
+        const std::lock_guard lock(writer_mutex_);
+        std::unique_ptr<T> previous(current_.exchange(version.release()));
+        // Читатель, получивший previous, отметил эпоху до замены указателя, то есть меньшую
+        retired_.push_back({ std::move(previous), epoch_.fetch_add(1) + 1 });
+        CollectLocked();
+    }
+
+    // Удаляет снятые версии, которые больше никто не читает. Возвращает число ещё не удалённых
+    size_t Collect() {
+        const std::lock_guard lock(writer_mutex_);
+        CollectLocked();
+        return retired_.size();
+    }
+
+private:
+    static constexpr uint64_t IDLE = ~uint64_t{ 0 };
+
+    struct Slot {
+        // Эпоха, в которой читатель взял версию, или IDLE вне чтения.
+        // Слоты разных потоков лежат в разных строках кеша
+        alignas(64) std::atomic<uint64_t> epoch{ IDLE };
+        std::atomic<bool> is_taken{ false };
+    };
+
+    struct RetiredVersion {
+        std::unique_ptr<T> version;
+        // Эпоха после снятия: читатели с отметкой не меньше неё версию уже не видят
+        uint64_t epoch;
+    };
+
+    void CollectLocked() {
+        uint64_t min_epoch = IDLE;
+        for (size_t idx = 0; idx < slot_count_; ++idx) {
+            min_epoch = std::min(min_epoch, slots_[idx].epoch.load());
+        }
+        retired_.erase(std::remove_if(retired_.begin(), retired_.end(),
+            [min_epoch](const RetiredVersion& retired) {
+                return retired.epoch <= min_epoch;
+            }), retired_.end());
+    }
+
+    std::atomic<T*> current_;
+    std::atomic<uint64_t> epoch_{ 0 };
+    std::unique_ptr<Slot[]> slots_;
+    size_t slot_count_;
+
+    // Писатели и сборка снятых версий не мешают читателям, но упорядочены между собой
+    std::mutex writer_mutex_;
+    std::vector<RetiredVersion> retired_;
+};
+
+} // end namespace server
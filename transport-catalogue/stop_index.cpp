@@ -0,0 +1,125 @@
+#define _USE_MATH_DEFINES
+#include "stop_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+
+namespace transport::detail {
+
+namespace {
+
+// Тот же радиус, что и в geo::ComputeDistance
+constexpr double EARTH_RADIUS = 6371000;
+constexpr double DEGREE = M_PI / 180.0;
+
+} // namespace
+
+StopIndex::StopIndex(double cell_size)
+    : cell_size_(cell_size)
+    , column_count_(static_cast<int64_t>(std::ceil(360.0 / cell_size))) {
+}
+
+void StopIndex::Add(Stop* stop) {
+    auto& cell = cells_[GetCellId(ToRow(stop->coordinates.lat), ToColumn(stop->coordinates.lng))];
+    cell.stops.push_back(stop);
+    cell.points.push_back(stop->trig_coordinates);
+    ++stop_count_;
+}
+
+std::vector<StopDistance> StopIndex::FindInRadius(geo::Coordinates point, double radius) const {
+    std::vector<StopDistance> result;
+    if (!(radius >= 0) || cells_.empty()) {
+        return result;
+    }
+
+    // Круг радиуса angle на сфере лежит в полосе широт [lat - angle, lat + angle],
+    // а если не задевает полюс, то и в полосе долгот lng ± asin(sin(angle) / cos(lat))
+    const double angle = radius / EARTH_RADIUS;
+    const double min_lat = point.lat - angle / DEGREE;
+    const double max_lat = point.lat + angle / DEGREE;
+    bool is_all_columns = angle >= M_PI / 2 || min_lat <= -90 || max_lat >= 90;
+    double lng_delta = 0;
+    if (!is_all_columns) {
+        const double ratio = std::sin(angle) / std::cos(point.lat * DEGREE);
+        is_all_columns = ratio >= 1;
+        lng_delta = is_all_columns ? 0 : std::asin(ratio) / DEGREE;
+    }
+
+    const geo::TrigCoordinates trig_point(point);
+    const int64_t min_row = ToRow(std::max(min_lat, -90.0));
+    const int64_t max_row = ToRow(std::min(max_lat, 90.0));
+    const int64_t min_column = is_all_columns ? 0 : ToColumn(point.lng - lng_delta);
+    const int64_t column_span = is_all_columns
+        ? column_count_
+        : std::min(ToColumn(point.lng + lng_delta) - min_column + 1, column_count_);
+
+    // Большой круг пересекает больше ячеек, чем занято: проще просмотреть все занятые
+    if (static_cast<double>(max_row - min_row + 1) * column_span >= static_cast<double>(cells_.size())) {
+        for (const auto& [cell_id, cell] : cells_) {
+            CollectCell(cell, trig_point, radius, result);
+        }
+    }
+    else {
+        for (int64_t row = min_row; row <= max_row; ++row) {
+            for (int64_t column = min_column; column < min_column + column_span; ++column) {
+                if (const auto it = cells_.find(GetCellId(row, column)); it != cells_.end()) {
+                    CollectCell(it->second, trig_point, radius, result);
+                }
+            }
+        }
+    }
+
+    std::sort(result.begin(), result.end(), [](const StopDistance& lhs, const StopDistance& rhs) {
+        return std::tie(lhs.distance, lhs.stop->name) < std::tie(rhs.distance, rhs.stop->name);
+    });
+    return result;
+}
+
+// Радиус поиска удваивается, пока в круг не попадёт count остановок.
+// Любая остановка вне круга дальше любой найденной, поэтому найденные - ближайшие
+std::vector<StopDistance> StopIndex::FindNearest(geo::Coordinates point, size_t count) const {
+    if (count == 0 || stop_count_ == 0) {
+        return {};
+    }
+
+    double radius = cell_size_ * DEGREE * EARTH_RADIUS;
+    while (true) {
+        auto result = FindInRadius(point, radius);
+        if (result.size() >= count || radius >= M_PI * EARTH_RADIUS) {
+            result.resize(std::min(result.size(), count));
+            return result;
+        }
+        radius *= 2;
+    }
+}
+
+int64_t StopIndex::ToRow(double lat) const {
+    return static_cast<int64_t>(std::floor((lat + 90.0) / cell_size_));
+}
+
+int64_t StopIndex::ToColumn(double lng) const {
+    return static_cast<int64_t>(std::floor((lng + 180.0) / cell_size_));
+}
+
+uint64_t StopIndex::GetCellId(int64_t row, int64_t column) const {
+    column %= column_count_;
+    if (column < 0) {
+        column += column_count_;
+    }
+    return static_cast<uint64_t>(row) * static_cast<uint64_t>(column_count_) + static_cast<uint64_t>(column);
+}
+
+void StopIndex::CollectCell(const Cell& cell, const geo::TrigCoordinates& point, double radius,
+                            std::vector<StopDistance>& result) const {
+    const auto distances = geo::ComputeDistances(point, cell.points);
+    for (size_t i = 0; i < distances.size(); ++i) {
+        // Для совпадающих точек аргумент acos может чуть превысить 1
+        const double distance = std::isnan(distances[i]) ? 0.0 : distances[i];
+        if (distance <= radius) {
+            result.push_back({ cell.stops[i], distance });
+        }
+    }
+}
+
+} // end namespace transport::detail
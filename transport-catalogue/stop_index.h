@@ -0,0 +1,51 @@
+#pragma once
+
+#include "domain.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace transport::detail {
+
+struct StopDistance {
+    Stop* stop;
+    // Расстояние по поверхности Земли в метрах
+    double distance;
+};
+
+// Сетка остановок по широте и долготе. Остановки добавляются по одной, поиск
+// просматривает только ячейки, которые пересекает круг поиска
+class StopIndex {
+public:
+    // cell_size - сторона ячейки в градусах
+    explicit StopIndex(double cell_size = 0.01);
+
+    void Add(Stop* stop);
+
+    // Остановки не дальше radius метров от point по возрастанию расстояния
+    std::vector<StopDistance> FindInRadius(geo::Coordinates point, double radius) const;
+    // count ближайших к point остановок по возрастанию расстояния
+    std::vector<StopDistance> FindNearest(geo::Coordinates point, size_t count) const;
+
+private:
+    int64_t ToRow(double lat) const;
+    int64_t ToColumn(double lng) const;
+    // Номер столбца берётся по модулю: долгота 180 совпадает с -180
+    uint64_t GetCellId(int64_t row, int64_t column) const;
+    // Координаты остановок ячейки лежат подряд, расстояния до них считаются одним вызовом
+    struct Cell {
+        std::vector<Stop*> stops;
+        std::vector<geo::TrigCoordinates> points;
+    };
+
+    void CollectCell(const Cell& cell, const geo::TrigCoordinates& point, double radius,
+                     std::vector<StopDistance>& result) const;
+
+    double cell_size_;
+    int64_t column_count_;
+    size_t stop_count_ = 0;
+    std::unordered_map<uint64_t, Cell> cells_;
+};
+
+} // end namespace transport::detail
@@ -1,88 +1,150 @@
 #include "svg.h"
 
+#include <charconv>
+
 namespace svg {
 
     using namespace std::literals;
 
     namespace {
 
-        void RenderColor(std::ostream& out, std::monostate) {
-            out << "none"s;
+        void RenderColor(Writer& out, std::monostate) {
+            out << "none"sv;
         }
 
-        void RenderColor(std::ostream& out, const std::string& value) {
-            out << value;
+        void RenderColor(Writer& out, const std::string& value) {
+            out << std::string_view(value);
         }
 
-        void RenderColor(std::ostream& out, Rgb rgb) {
+        void RenderColor(Writer& out, Rgb rgb) {
             out << "rgb("sv << static_cast<int>(rgb.red)  //
                 << ',' << static_cast<int>(rgb.green)     //
                 << ',' << static_cast<int>(rgb.blue) << ')';
         }
 
-        void RenderColor(std::ostream& out, Rgba rgba) {
+        void RenderColor(Writer& out, Rgba rgba) {
             out << "rgba("sv << static_cast<int>(rgba.red)  //
                 << ',' << static_cast<int>(rgba.green)      //
                 << ',' << static_cast<int>(rgba.blue)       //
                 << ',' << rgba.opacity << ')';
         }
 
+        std::string_view ToString(StrokeLineCap value) {
+            switch (value) {
+                case StrokeLineCap::BUTT:
+                    return "butt"sv;
+                case StrokeLineCap::ROUND:
+                    return "round"sv;
+                case StrokeLineCap::SQUARE:
+                    return "square"sv;
+            }
+            return {};
+        }
+
+        std::string_view ToString(StrokeLineJoin value) {
+            switch (value) {
+                case StrokeLineJoin::ARCS:
+                    return "arcs"sv;
+                case StrokeLineJoin::BEVEL:
+                    return "bevel"sv;
+                case StrokeLineJoin::MITER:
+                    return "miter"sv;
+                case StrokeLineJoin::MITER_CLIP:
+                    return "miter-clip"sv;
+                case StrokeLineJoin::ROUND:
+                    return "round"sv;
+            }
+            return {};
+        }
+
+        template <typename Number>
+        void AppendNumber(std::string& out, Number value) {
+            char buffer[16];
+            const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+            out.append(buffer, result.ptr);
+        }
+
     }  // namespace
 
     std::ostream& operator<<(std::ostream& out, const Color& color) {
-        std::visit(
-                [&out](const auto& value) {
-                    RenderColor(out, value);
-                },
-                color);
-        return out;
+        std::string text;
+        Writer(text) << color;
+        return out << text;
     }
 
     std::ostream& operator<<(std::ostream& out, StrokeLineCap value) {
-        std::string_view sv;
-        switch (value) {
-            case StrokeLineCap::BUTT:
-                sv = "butt"sv;
-                break;
-            case StrokeLineCap::ROUND:
-                sv = "round"sv;
-                break;
-            case StrokeLineCap::SQUARE:
-                sv = "square"sv;
-                break;
-        }
-        return out << sv;
+        return out << ToString(value);
     }
 
     std::ostream& operator<<(std::ostream& out, StrokeLineJoin value) {
-        std::string_view sv;
-        switch (value) {
-            case StrokeLineJoin::ARCS:
-                sv = "arcs"sv;
-                break;
-            case StrokeLineJoin::BEVEL:
-                sv = "bevel"sv;
-                break;
-            case StrokeLineJoin::MITER:
-                sv = "miter"sv;
-                break;
-            case StrokeLineJoin::MITER_CLIP:
-                sv = "miter-clip"sv;
-                break;
-            case StrokeLineJoin::ROUND:
-                sv = "round"sv;
-                break;
-        }
-        return out << sv;
+        return out << ToString(value);
     }
 
-    void Object::Render(const RenderContext& context) const {
-        context.RenderIndent();
+// Writer
 
-        //     
-        RenderObject(context);
+    Writer& Writer::operator<<(int value) {
+        AppendNumber(out_, value);
+        return *this;
+    }
 
-        context.out << std::endl;
+    Writer& Writer::operator<<(uint32_t value) {
+        AppendNumber(out_, value);
+        return *this;
+    }
+
+    Writer& Writer::operator<<(double value) {
+        //  %g   6,   std::ostream  
+        char buffer[32];
+        const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value,
+                                          std::chars_format::general, 6);
+        out_.append(buffer, result.ptr);
+        return *this;
+    }
+
+    Writer& Writer::operator<<(const Color& color) {
+        std::visit(
+                [this](const auto& value) {
+                    RenderColor(*this, value);
+                },
+                color);
+        return *this;
+    }
+
+    Writer& Writer::operator<<(StrokeLineCap value) {
+        return *this << ToString(value);
+    }
+
+    Writer& Writer::operator<<(StrokeLineJoin value) {
+        return *this << ToString(value);
+    }
+
+    void Writer::WriteEscaped(std::string_view str) {
+        //     
+        while (!str.empty()) {
+            const size_t pos = str.find_first_of("\"<>&'"sv);
+            out_.append(str.substr(0, pos));
+            if (pos == std::string_view::npos) {
+                break;
+            }
+            switch (str[pos]) {
+                case '"':
+                    out_.append("&quot;"sv);
+                    break;
+                case '<':
+                    out_.append("&lt;"sv);
+                    break;
+                case '>':
+                    out_.append("&gt;"sv);
+                    break;
+                case '&':
+                    out_.append("&amp;"sv);
+                    break;
+                default:
+                    out_.append("&apos;"sv);
+                    break;
+            }
+            str.remove_prefix(pos + 1);
+        }
     }
 
 // Circle
@@ -97,8 +159,7 @@ namespace svg {
         return *this;
     }
 
-    void Circle::RenderObject(const RenderContext& context) const {
-        auto& out = context.out;
+    void Circle::Render(Writer& out) const {
         out << "<circle cx=\""sv << center_.x << "\" cy=\""sv << center_.y << "\" "sv;
         out << "r=\""sv << radius_ << "\" "sv;
         RenderAttrs(out);
@@ -112,8 +173,7 @@ namespace svg {
         return *this;
     }
 
-    void Polyline::RenderObject(const RenderContext& context) const {
-        auto& out = context.out;
+    void Polyline::Render(Writer& out) const {
         out << "<polyline points=\""sv;
         bool first = true;
         for (const Point& p : points_) {
@@ -161,8 +221,7 @@ namespace svg {
         return *this;
     }
 
-    void Text::RenderObject(const RenderContext& context) const {
-        auto& out = context.out;
+    void Text::Render(Writer& out) const {
         out << "<text "sv;
         RenderAttrs(out);
         using detail::RenderAttr;
@@ -177,53 +236,43 @@ namespace svg {
         if (!font_weight_.empty()) {
             RenderAttr(out, " font-weight"sv, font_weight_);
         }
-        out.put('>');
-        detail::HtmlEncodeString(out, data_);
+        out << '>';
+        out.WriteEscaped(data_);
         out << "</text>"sv;
     }
 
 // Document
 
-    void Document::AddPtr(std::unique_ptr<Object>&& obj) {
-        objects_.push_back(std::move(obj));
+    void Document::SetViewBox(double min_x, double min_y, double width, double height) {
+        view_box_ = {min_x, min_y, width, height};
     }
 
     void Document::Render(std::ostream& out) const {
-        out << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>"sv << std::endl;
-        out << "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">"sv << std::endl;
-        RenderContext ctx{out, 2, 2};
-        for (const auto& obj : objects_) {
-            obj->Render(ctx);
+        std::string text;
+        Render(text);
+        out << text;
+    }
+
+    void Document::Render(std::string& out) const {
+        Writer writer(out);
+        writer << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\n"sv;
+        writer << "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\""sv;
+        if (view_box_) {
+            const auto& [min_x, min_y, width, height] = *view_box_;
+            writer << " viewBox=\""sv << min_x << ' ' << min_y << ' ' << width << ' ' << height << '"';
         }
-        out << "</svg>"sv;
-    }
-
-    namespace detail {
-
-        void HtmlEncodeString(std::ostream& out, std::string_view sv) {
-            for (char c : sv) {
-                switch (c) {
-                    case '"':
-                        out << "&quot;"sv;
-                        break;
-                    case '<':
-                        out << "&lt;"sv;
-                        break;
-                    case '>':
-                        out << "&gt;"sv;
-                        break;
-                    case '&':
-                        out << "&amp;"sv;
-                        break;
-                    case '\'':
-                        out << "&apos;"sv;
-                        break;
-                    default:
-                        out.put(c);
-                }
-            }
+        writer << ">\n"sv;
+        RenderContext ctx{writer, 2, 2};
+        for (const auto& obj : objects_) {
+            ctx.RenderIndent();
+            std::visit(
+                    [&writer](const auto& object) {
+                        object.Render(writer);
+                    },
+                    obj);
+            writer << '\n';
         }
-
-    }  // namespace detail
+        writer << "</svg>"sv;
+    }
 
 }  // namespace svg
\ No newline at end of file
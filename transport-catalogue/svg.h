@@ -1,8 +1,8 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
 #include <iostream>
-#include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
@@ -11,38 +11,6 @@
 
 namespace svg {
 
-    namespace detail {
-
-        template <typename T>
-        inline void RenderValue(std::ostream& out, const T& value) {
-            out << value;
-        }
-
-        void HtmlEncodeString(std::ostream& out, std::string_view sv);
-
-        template <>
-        inline void RenderValue<std::string>(std::ostream& out, const std::string& s) {
-            HtmlEncodeString(out, s);
-        }
-
-        template <typename AttrType>
-        inline void RenderAttr(std::ostream& out, std::string_view name, const AttrType& value) {
-            using namespace std::literals;
-            out << name << "=\""sv;
-            RenderValue(out, value);
-            out.put('"');
-        }
-
-        template <typename AttrType>
-        inline void RenderOptionalAttr(std::ostream& out, std::string_view name,
-                                       const std::optional<AttrType>& value) {
-            if (value) {
-                RenderAttr(out, name, *value);
-            }
-        }
-
-    }  // namespace detail
-
     struct Point {
         Point() = default;
         Point(double x, double y)
@@ -85,16 +53,100 @@ namespace svg {
 
     std::ostream& operator<<(std::ostream& out, const Color& color);
 
+    enum class StrokeLineCap {
+        BUTT,
+        ROUND,
+        SQUARE,
+    };
+
+    std::ostream& operator<<(std::ostream& out, StrokeLineCap value);
+
+    enum class StrokeLineJoin {
+        ARCS,
+        BEVEL,
+        MITER,
+        MITER_CLIP,
+        ROUND,
+    };
+
+    std::ostream& operator<<(std::ostream& out, StrokeLineJoin value);
+
+/*
+ *  SVG-      .
+ *   std::to_chars    ,   std::ostream
+ *    
+ */
+    class Writer {
+    public:
+        explicit Writer(std::string& out)
+                : out_(out) {
+        }
+
+        Writer& operator<<(std::string_view str) {
+            out_.append(str);
+            return *this;
+        }
+        Writer& operator<<(char c) {
+            out_.push_back(c);
+            return *this;
+        }
+        Writer& operator<<(int value);
+        Writer& operator<<(uint32_t value);
+        Writer& operator<<(double value);
+        Writer& operator<<(const Color& color);
+        Writer& operator<<(StrokeLineCap value);
+        Writer& operator<<(StrokeLineJoin value);
+
+        //   ", <, >, &  '  XML-
+        void WriteEscaped(std::string_view str);
+        void WriteIndent(int indent) {
+            out_.append(static_cast<size_t>(indent), ' ');
+        }
+
+    private:
+        std::string& out_;
+    };
+
+    namespace detail {
+
+        template <typename T>
+        inline void RenderValue(Writer& out, const T& value) {
+            out << value;
+        }
+
+        template <>
+        inline void RenderValue<std::string>(Writer& out, const std::string& s) {
+            out.WriteEscaped(s);
+        }
+
+        template <typename AttrType>
+        inline void RenderAttr(Writer& out, std::string_view name, const AttrType& value) {
+            using namespace std::literals;
+            out << name << "=\""sv;
+            RenderValue(out, value);
+            out << '"';
+        }
+
+        template <typename AttrType>
+        inline void RenderOptionalAttr(Writer& out, std::string_view name,
+                                       const std::optional<AttrType>& value) {
+            if (value) {
+                RenderAttr(out, name, *value);
+            }
+        }
+
+    }  // namespace detail
+
 /*
  *  ,     SVG-  .
- *     ,        
+ *     ,        
  */
     struct RenderContext {
-        RenderContext(std::ostream& out)
+        RenderContext(Writer& out)
                 : out(out) {
         }
 
-        RenderContext(std::ostream& out, int indent_step, int indent = 0)
+        RenderContext(Writer& out, int indent_step, int indent = 0)
                 : out(out)
                 , indent_step(indent_step)
                 , indent(indent) {
@@ -105,49 +157,14 @@ namespace svg {
         }
 
         void RenderIndent() const {
-            for (int i = 0; i < indent; ++i) {
-                out.put(' ');
-            }
+            out.WriteIndent(indent);
         }
 
-        std::ostream& out;
+        Writer& out;
         int indent_step = 0;
         int indent = 0;
     };
 
-/*
- *    Object    
- *   SVG-
- *   " "    
- */
-    class Object {
-    public:
-        void Render(const RenderContext& context) const;
-
-        virtual ~Object() = default;
-
-    private:
-        virtual void RenderObject(const RenderContext& context) const = 0;
-    };
-
-    enum class StrokeLineCap {
-        BUTT,
-        ROUND,
-        SQUARE,
-    };
-
-    std::ostream& operator<<(std::ostream& out, StrokeLineCap value);
-
-    enum class StrokeLineJoin {
-        ARCS,
-        BEVEL,
-        MITER,
-        MITER_CLIP,
-        ROUND,
-    };
-
-    std::ostream& operator<<(std::ostream& out, StrokeLineJoin value);
-
     template <typename Owner>
     class PathProps {
     public:
@@ -175,7 +192,7 @@ namespace svg {
     protected:
         ~PathProps() = default;
 
-        void RenderAttrs(std::ostream& out) const {
+        void RenderAttrs(Writer& out) const {
             using detail::RenderOptionalAttr;
             using namespace std::literals;
             RenderOptionalAttr(out, "fill"sv, fill_color_);
@@ -205,14 +222,15 @@ namespace svg {
  *   PathProps<Circle>,  "" ,
  *      Circle
  */
-    class Circle : public Object, public PathProps<Circle> {
+    class Circle : public PathProps<Circle> {
     public:
         Circle& SetCenter(Point center);
         Circle& SetRadius(double radius);
 
-    private:
-        void RenderObject(const RenderContext& context) const override;
+        //       
+        void Render(Writer& out) const;
 
+    private:
         Point center_;
         double radius_ = 1.0;
     };
@@ -221,13 +239,14 @@ namespace svg {
  *  Polyline   <polyline>    
  * https://developer.mozilla.org/en-US/docs/Web/SVG/Element/polyline
  */
-    class Polyline : public Object, public PathProps<Polyline> {
+    class Polyline : public PathProps<Polyline> {
     public:
         //      
         Polyline& AddPoint(Point point);
 
+        void Render(Writer& out) const;
+
     private:
-        void RenderObject(const RenderContext& context) const override;
         std::vector<Point> points_;
     };
 
@@ -235,7 +254,7 @@ namespace svg {
  *  Text   <text>   
  * https://developer.mozilla.org/en-US/docs/Web/SVG/Element/text
  */
-    class Text : public Object, public PathProps<Text> {
+    class Text : public PathProps<Text> {
     public:
         //     ( x  y)
         Text& SetPosition(Point pos);
@@ -255,8 +274,9 @@ namespace svg {
         //     (   text)
         Text& SetData(std::string data);
 
+        void Render(Writer& out) const;
+
     private:
-        void RenderObject(const RenderContext& context) const override;
         Point position_;
         Point offset_;
         uint32_t font_size_ = 1;
@@ -266,47 +286,30 @@ namespace svg {
     };
 
 /*
- * ,   SVG .
+ *  SVG-.      ,
+ *        
  */
-    class ObjectContainer {
+    using Object = std::variant<Circle, Polyline, Text>;
+
+    class Document {
     public:
+        //   svg-  Circle, Polyline  Text
         template <typename ObjectType>
         void Add(ObjectType object) {
-            AddPtr(std::make_unique<ObjectType>(std::move(object)));
+            objects_.emplace_back(std::move(object));
         }
 
-        //   svg- - svg::Object
-        virtual void AddPtr(std::unique_ptr<Object>&& obj) = 0;
-
-    protected:
-        //     
-        //     
-        ~ObjectContainer() = default;
-    };
-
-/*
- *  ,       ,
- *   ObjectContainer
- */
-    class Drawable {
-    public:
-        virtual void Draw(ObjectContainer& container) const = 0;
-
-        //  Drawable   .    
-        // 
-        virtual ~Drawable() = default;
-    };
-
-    class Document : public ObjectContainer {
-    public:
-        //   svg- - svg::Object
-        void AddPtr(std::unique_ptr<Object>&& obj) override;
+        //     ( viewBox)
+        void SetViewBox(double min_x, double min_y, double width, double height);
 
         //   ostream svg- 
         void Render(std::ostream& out) const;
+        //  svg-    out
+        void Render(std::string& out) const;
 
     private:
-        std::vector<std::unique_ptr<Object>> objects_;
+        std::vector<Object> objects_;
+        std::optional<std::array<double, 4>> view_box_;
     };
 
 }  // namespace svg
\ No newline at end of file
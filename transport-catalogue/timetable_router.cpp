@@ -0,0 +1,286 @@
+#include "timetable_router.h"
+#include "serialization.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace transport::router {
+
+namespace {
+
+constexpr double NO_TIME = std::numeric_limits<double>::infinity();
+
+// How a stop was reached in a round: by route from its board_idx-th to alight_idx-th stop,
+// boarding with the arrival of round board_round
+struct Label {
+    double arrival_time;
+    double trip_departure_time;
+    uint32_t route;
+    uint32_t board_idx;
+    uint32_t alight_idx;
+    uint32_t board_round;
+};
+
+// Scratch buffers of a query, reused between queries of one thread. Entries of stops
+// reached by a query are reset at its end, labels are only read where they were written
+struct SearchData {
+    static constexpr uint32_t NO_IDX = std::numeric_limits<uint32_t>::max();
+
+    // Best arrival with any number of rides and with fewer rides than the current round
+    std::vector<double> arrival_times;
+    std::vector<uint32_t> arrival_rounds;
+    std::vector<double> prev_arrival_times;
+    std::vector<uint32_t> prev_arrival_rounds;
+    std::vector<std::vector<Label>> labels;
+    std::vector<detail::StopId> reached_stops;
+
+    std::vector<bool> is_marked;
+    std::vector<detail::StopId> marked_stops;
+    // First stop to scan from by route, NO_IDX for routes not queued
+    std::vector<uint32_t> route_first_idx;
+    std::vector<uint32_t> queued_routes;
+
+    void Prepare(size_t stop_count, size_t route_count) {
+        if (arrival_times.size() < stop_count) {
+            arrival_times.resize(stop_count, NO_TIME);
+            arrival_rounds.resize(stop_count);
+            prev_arrival_times.resize(stop_count, NO_TIME);
+            prev_arrival_rounds.resize(stop_count);
+            is_marked.resize(stop_count, false);
+        }
+        if (route_first_idx.size() < route_count) {
+            route_first_idx.resize(route_count, NO_IDX);
+        }
+    }
+
+    std::vector<Label>& GetRoundLabels(uint32_t round, size_t stop_count) {
+        if (labels.size() <= round) {
+            labels.resize(round + 1);
+        }
+        if (labels[round].size() < stop_count) {
+            labels[round].resize(stop_count);
+        }
+        return labels[round];
+    }
+
+    void Reach(detail::StopId stop, double time, uint32_t round) {
+        if (arrival_times[stop] == NO_TIME) {
+            reached_stops.push_back(stop);
+        }
+        arrival_times[stop] = time;
+        arrival_rounds[stop] = round;
+        if (!is_marked[stop]) {
+            is_marked[stop] = true;
+            marked_stops.push_back(stop);
+        }
+    }
+
+    void Reset() {
+        for (const detail::StopId stop : reached_stops) {
+            arrival_times[stop] = NO_TIME;
+            prev_arrival_times[stop] = NO_TIME;
+        }
+        reached_stops.clear();
+        for (const detail::StopId stop : marked_stops) {
+            is_marked[stop] = false;
+        }
+        marked_stops.clear();
+    }
+};
+
+SearchData& GetThreadSearchData(size_t stop_count, size_t route_count) {
+    thread_local SearchData search_data;
+    search_data.Prepare(stop_count, route_count);
+    return search_data;
+}
+
+} // namespace
+
+TimetableRouter::TimetableRouter(const Catalogue& catalogue, double meters_per_minute) {
+    for (const auto& stop : catalogue.GetStops()) {
+        stops_.push_back(&stop);
+    }
+
+    route_stop_offsets_.push_back(0);
+    trip_offsets_.push_back(0);
+    for (const auto& bus : catalogue.GetBuses()) {
+        if (bus.stops.size() <= 1 || bus.departures.empty()) {
+            continue;
+        }
+        routes_.push_back(&bus);
+        const auto& route_distances = catalogue.GetRouteDistances(&bus);
+        for (size_t idx = 0; idx < bus.stops.size(); ++idx) {
+            route_stops_.push_back(bus.stops[idx]->id);
+            ride_offsets_.push_back(route_distances[idx] / meters_per_minute);
+        }
+        route_stop_offsets_.push_back(static_cast<uint32_t>(route_stops_.size()));
+        departures_.insert(departures_.end(), bus.departures.begin(), bus.departures.end());
+        trip_offsets_.push_back(static_cast<uint32_t>(departures_.size()));
+    }
+
+    // Counting pass, then placement pass
+    stop_route_offsets_.assign(stops_.size() + 1, 0);
+    for (const detail::StopId stop : route_stops_) {
+        ++stop_route_offsets_[stop + 1];
+    }
+    for (size_t stop = 1; stop < stop_route_offsets_.size(); ++stop) {
+        stop_route_offsets_[stop] += stop_route_offsets_[stop - 1];
+    }
+    stop_routes_.resize(route_stops_.size());
+    std::vector<uint32_t> filled(stop_route_offsets_.begin(), stop_route_offsets_.end() - 1);
+    for (uint32_t route = 0; route < routes_.size(); ++route) {
+        for (uint32_t idx = route_stop_offsets_[route]; idx < route_stop_offsets_[route + 1]; ++idx) {
+            stop_routes_[filled[route_stops_[idx]]++] = { route, idx - route_stop_offsets_[route] };
+        }
+    }
+}
+
+TimetableRouter::TimetableRouter(serialization::InputArchive& archive,
+                                 const serialization::CatalogueIndex& index) {
+    stops_.resize(archive.Read<uint64_t>());
+    for (uint32_t stop_id = 0; stop_id < stops_.size(); ++stop_id) {
+        stops_[stop_id] = index.GetStop(stop_id);
+    }
+    for (const uint32_t bus_id : archive.ReadVector<uint32_t>()) {
+        routes_.push_back(index.GetBus(bus_id));
+    }
+    route_stop_offsets_ = archive.ReadVector<uint32_t>();
+    route_stops_ = archive.ReadVector<detail::StopId>();
+    ride_offsets_ = archive.ReadVector<double>();
+    trip_offsets_ = archive.ReadVector<uint32_t>();
+    departures_ = archive.ReadVector<double>();
+    stop_route_offsets_ = archive.ReadVector<uint32_t>();
+    stop_routes_ = archive.ReadVector<StopRoute>();
+
+    if (route_stop_offsets_.size() != routes_.size() + 1 || trip_offsets_.size() != routes_.size() + 1
+        || stop_route_offsets_.size() != stops_.size() + 1 || ride_offsets_.size() != route_stops_.size()
+        || stop_routes_.size() != route_stops_.size()
+        || std::any_of(route_stops_.begin(), route_stops_.end(), [this](detail::StopId stop) {
+               return stop >= stops_.size();
+           })) {
+        throw serialization::FormatError("Timetable does not match the catalogue");
+    }
+}
+
+void TimetableRouter::Save(serialization::OutputArchive& archive,
+                           const serialization::CatalogueIndex& index) const {
+    archive.Write(static_cast<uint64_t>(stops_.size()));
+    std::vector<uint32_t> bus_ids;
+    bus_ids.reserve(routes_.size());
+    for (const auto* bus : routes_) {
+        bus_ids.push_back(index.GetBusId(bus));
+    }
+    archive.WriteVector(bus_ids);
+    archive.WriteVector(route_stop_offsets_);
+    archive.WriteVector(route_stops_);
+    archive.WriteVector(ride_offsets_);
+    archive.WriteVector(trip_offsets_);
+    archive.WriteVector(departures_);
+    archive.WriteVector(stop_route_offsets_);
+    archive.WriteVector(stop_routes_);
+}
+
+std::optional<Journey> TimetableRouter::FindJourney(const detail::Stop* from, const detail::Stop* to,
+                                                    double departure_time) const {
+    const detail::StopId source = from->id;
+    const detail::StopId target = to->id;
+    if (source >= stops_.size() || target >= stops_.size()) {
+        throw std::out_of_range("Stop id is out of range");
+    }
+    if (source == target) {
+        return Journey{ departure_time, departure_time, {} };
+    }
+
+    SearchData& data = GetThreadSearchData(stops_.size(), routes_.size());
+    data.Reach(source, departure_time, 0);
+
+    for (uint32_t round = 1; !data.marked_stops.empty(); ++round) {
+        // Boarding uses arrivals with fewer rides, they are fixed for the whole round
+        for (const detail::StopId stop : data.marked_stops) {
+            data.is_marked[stop] = false;
+            data.prev_arrival_times[stop] = data.arrival_times[stop];
+            data.prev_arrival_rounds[stop] = data.arrival_rounds[stop];
+            for (uint32_t idx = stop_route_offsets_[stop]; idx < stop_route_offsets_[stop + 1]; ++idx) {
+                const auto [route, stop_idx] = stop_routes_[idx];
+                if (data.route_first_idx[route] == SearchData::NO_IDX) {
+                    data.queued_routes.push_back(route);
+                    data.route_first_idx[route] = stop_idx;
+                } else {
+                    data.route_first_idx[route] = std::min(data.route_first_idx[route], stop_idx);
+                }
+            }
+        }
+        data.marked_stops.clear();
+
+        std::vector<Label>& labels = data.GetRoundLabels(round, stops_.size());
+        for (const uint32_t route : data.queued_routes) {
+            const uint32_t stops_begin = route_stop_offsets_[route];
+            const uint32_t stop_count = route_stop_offsets_[route + 1] - stops_begin;
+            const double* trips_begin = departures_.data() + trip_offsets_[route];
+            const double* trips_end = departures_.data() + trip_offsets_[route + 1];
+
+            // Trip the passenger is riding, trips_end before boarding
+            const double* trip = trips_end;
+            uint32_t board_idx = 0;
+            uint32_t board_round = 0;
+            for (uint32_t stop_idx = data.route_first_idx[route]; stop_idx < stop_count; ++stop_idx) {
+                const detail::StopId stop = route_stops_[stops_begin + stop_idx];
+                const double ride_offset = ride_offsets_[stops_begin + stop_idx];
+
+                // Arrivals later than the best one at the target cannot be part of a better journey
+                if (trip != trips_end) {
+                    const double arrival_time = *trip + ride_offset;
+                    if (arrival_time < data.arrival_times[stop] && arrival_time < data.arrival_times[target]) {
+                        data.Reach(stop, arrival_time, round);
+                        labels[stop] = { arrival_time, *trip, route, board_idx, stop_idx, board_round };
+                    }
+                }
+
+                // An earlier trip can be caught if the passenger got here before the current one
+                const double ready_time = data.prev_arrival_times[stop];
+                if (ready_time == NO_TIME || (trip != trips_end && !(ready_time < *trip + ride_offset))) {
+                    continue;
+                }
+                const double* earliest_trip = std::partition_point(trips_begin, trip,
+                    [ride_offset, ready_time](double departure) {
+                        return departure + ride_offset < ready_time;
+                    });
+                if (earliest_trip != trip) {
+                    trip = earliest_trip;
+                    board_idx = stop_idx;
+                    board_round = data.prev_arrival_rounds[stop];
+                }
+            }
+            data.route_first_idx[route] = SearchData::NO_IDX;
+        }
+        data.queued_routes.clear();
+    }
+
+    std::optional<Journey> journey;
+    if (data.arrival_times[target] != NO_TIME) {
+        journey = Journey{ departure_time, data.arrival_times[target], {} };
+        // Rides are restored backwards: each label points to the round its boarding stop was reached in
+        detail::StopId stop = target;
+        for (uint32_t round = data.arrival_rounds[target]; round > 0;) {
+            const Label& label = data.labels[round][stop];
+            const uint32_t stops_begin = route_stop_offsets_[label.route];
+            const detail::StopId board_stop = route_stops_[stops_begin + label.board_idx];
+            journey->rides.push_back({
+                routes_[label.route],
+                stops_[board_stop],
+                label.trip_departure_time + ride_offsets_[stops_begin + label.board_idx],
+                label.arrival_time,
+                label.alight_idx - label.board_idx,
+            });
+            stop = board_stop;
+            round = label.board_round;
+        }
+        std::reverse(journey->rides.begin(), journey->rides.end());
+    }
+
+    data.Reset();
+    return journey;
+}
+
+} // end namespace transport::router
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "transport_catalogue.h"
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace serialization {
+class CatalogueIndex;
+class InputArchive;
+class OutputArchive;
+}  // namespace serialization
+
+namespace transport::router {
+
+// Earliest arrival by bus when leaving the origin at a given time
+struct Journey {
+    struct Ride {
+        const detail::bus::Bus* bus;
+        const detail::Stop* stop;  // where the passenger boards
+        double departure_time = 0;
+        double arrival_time = 0;
+        size_t span_count = 0;
+    };
+
+    double departure_time = 0;
+    double arrival_time = 0;
+    std::vector<Ride> rides;
+};
+
+// Round-based public transit router (RAPTOR) over bus timetables. Every bus with departures
+// is a route, its trips leave the first stop at the scheduled times and run at bus velocity
+// without dwelling, so a trip reaches the i-th stop at its departure plus the ride offset of
+// that stop. Round k scans only the routes through stops improved in round k - 1 and finds
+// the best arrivals with k rides; times are minutes after midnight
+class TimetableRouter {
+public:
+    TimetableRouter() = default;
+    // meters_per_minute is the bus velocity used for ride times
+    TimetableRouter(const Catalogue& catalogue, double meters_per_minute);
+    TimetableRouter(serialization::InputArchive& archive, const serialization::CatalogueIndex& index);
+
+    void Save(serialization::OutputArchive& archive, const serialization::CatalogueIndex& index) const;
+
+    // nullopt if no trip gets to stop to after departure_time
+    std::optional<Journey> FindJourney(const detail::Stop* from, const detail::Stop* to,
+                                       double departure_time) const;
+
+private:
+    // The stop with the given index on the given route
+    struct StopRoute {
+        uint32_t route;
+        uint32_t stop_idx;
+    };
+
+    std::vector<const detail::Stop*> stops_;
+    std::vector<const detail::bus::Bus*> routes_;
+    // Stops of route r are route_stops_[route_stop_offsets_[r] .. route_stop_offsets_[r + 1]),
+    // ride_offsets_ holds the time from the first stop of the route to each of them
+    std::vector<uint32_t> route_stop_offsets_;
+    std::vector<detail::StopId> route_stops_;
+    std::vector<double> ride_offsets_;
+    // Sorted departures of route r are departures_[trip_offsets_[r] .. trip_offsets_[r + 1])
+    std::vector<uint32_t> trip_offsets_;
+    std::vector<double> departures_;
+    // Routes through stop s are stop_routes_[stop_route_offsets_[s] .. stop_route_offsets_[s + 1])
+    std::vector<uint32_t> stop_route_offsets_;
+    std::vector<StopRoute> stop_routes_;
+};
+
+}  // namespace transport::router
@@ -1,42 +1,91 @@
 #include "transport_catalogue.h"
 
+#include <algorithm>
+
 namespace transport {
 
 void Catalogue::AddStop(detail::Stop stop) {
      auto& ref = stops_.emplace_back(std::move(stop.name), stop.coordinates.lat, stop.coordinates.lng);
+     ref.id = static_cast<detail::StopId>(stops_.size() - 1);
      stopname_to_stop_[ref.name] = &ref;
+     stop_to_buses_.emplace_back();
+     stops_index_.Add(&ref);
 }
 
-void Catalogue::AddBus(detail::bus::Bus bus) {
+detail::bus::Bus* Catalogue::AddBus(detail::bus::Bus bus) {
     // Помещение оригинала автобуса в список (постоянное хранилище)
     auto& ref = buses_.emplace_back(std::move(bus.name), bus.stops, bus.final_stops, bus.is_roundtrip);
+    ref.id = static_cast<detail::BusId>(buses_.size() - 1);
+    ref.departures = std::move(bus.departures);
 
     // Добавление текущего автобуса ко всем остановкам, через которые он проезжает
     for (const auto stop : bus.stops) {
-        stop_to_buses_[stop->name].insert(&ref);
+        stop_to_buses_[stop->id].insert(&ref);
     }
 
     // Добавление автобуса в ассоциативный словарь для поиска по имени
     busname_to_bus_[ref.name] = &ref;
 
+    bus_infos_.emplace_back();
+    bus_route_distances_.emplace_back();
+    UpdateBusInfo(ref);
+    return &ref;
+}
+
+// Удалённый автобус остаётся в хранилище с пустым маршрутом: номера и указатели
+// остальных автобусов не меняются
+void Catalogue::RemoveBus(detail::bus::Bus* bus) {
+    for (const auto stop : bus->stops) {
+        stop_to_buses_[stop->id].erase(bus);
+    }
+    if (const auto it = busname_to_bus_.find(bus->name); it != busname_to_bus_.end() && it->second == bus) {
+        busname_to_bus_.erase(it);
+    }
+
+    bus->stops.clear();
+    bus->final_stops.clear();
+    bus->departures.clear();
+    bus->is_removed = true;
+    bus_infos_[bus->id] = {};
+    bus_route_distances_[bus->id].clear();
+}
+
+// Пересчитывает информацию об автобусе и накопленные расстояния вдоль его маршрута
+void Catalogue::UpdateBusInfo(const detail::bus::Bus& bus) {
     detail::bus::Info info;
     double fact_route_length = 0.0;
     double line_route_length = 0.0;
-    std::vector<detail::Stop*>& route = bus.stops;
+    const std::vector<detail::Stop*>& route = bus.stops;
 
     // Уникальные остановки
-    std::unordered_set<detail::Stop*> unique_stops(route.begin(), route.end());
-
-    // Расчёт длины маршрута по координатам
-    for (size_t i = 0; i < route.size() - 1; ++i) {
-        geo::Coordinates first = {(*route[i]).coordinates.lat, (*route[i]). coordinates.lng};
-        geo::Coordinates second = {(*route[i + 1]).coordinates.lat, (*route[i+ 1]).coordinates.lng};
-        line_route_length += ComputeDistance(first, second);
+    std::vector<detail::StopId> unique_stops;
+    unique_stops.reserve(route.size());
+    for (const auto stop : route) {
+        unique_stops.push_back(stop->id);
+    }
+    std::sort(unique_stops.begin(), unique_stops.end());
+    unique_stops.erase(std::unique(unique_stops.begin(), unique_stops.end()), unique_stops.end());
+
+    // Расчёт длины маршрута по координатам, синусы широт остановок посчитаны заранее
+    std::vector<geo::TrigCoordinates> points;
+    points.reserve(route.size());
+    for (const auto stop : route) {
+        points.push_back(stop->trig_coordinates);
+    }
+    for (const double distance : geo::ComputePathDistances(points)) {
+        line_route_length += distance;
     }
 
-    // Рассчёт длины маршрута по заданным пользователем значениям
-    for (size_t i = 0; i < route.size() - 1; ++i) {
-        fact_route_length += GetDistance(route[i], route[i + 1]);
+    // Рассчёт длины маршрута по заданным пользователем значениям.
+    // Суммы сохраняются: по ним маршрутизатор берёт расстояние между любыми двумя остановками автобуса
+    auto& route_distances = bus_route_distances_[bus.id];
+    route_distances.clear();
+    route_distances.reserve(route.size());
+    for (size_t i = 0; i < route.size(); ++i) {
+        if (i > 0) {
+            fact_route_length += GetDistance(route[i - 1], route[i]);
+        }
+        route_distances.push_back(fact_route_length);
     }
 
     info.total_stops = route.size();
@@ -44,8 +93,8 @@ void Catalogue::AddBus(detail::bus::Bus bus) {
     info.route_length = fact_route_length;
     info.curvature = fact_route_length / line_route_length;
 
-    // Добавление автобуса и информации о нем 
-    bus_to_info_[&ref] = info;
+    // Информация об автобусе хранится под его номером
+    bus_infos_[bus.id] = info;
 }
 
 const std::deque<detail::bus::Bus>& Catalogue::GetBuses() const {
@@ -59,21 +108,37 @@ const std::deque<detail::Stop>& Catalogue::GetStops() const {
 // Получает расстояние между двумя остановками
 double Catalogue::GetDistance(detail::Stop* a, detail::Stop* b) const {
     // Расстояние от А до Б
-    auto it = distances_between_stops_.find({ a, b });
+    auto distance = distances_between_stops_.Find(a->id, b->id);
 
-    if (it == distances_between_stops_.end()) {
+    if (!distance) {
         // Расстояние от Б до А
-        it = distances_between_stops_.find({ b, a });
-        if (it == distances_between_stops_.end()) {
+        distance = distances_between_stops_.Find(b->id, a->id);
+        if (!distance) {
             return -1;
         }
     }
 
-    return it->second;
+    return *distance;
 }
     
 void Catalogue::SetDistance(const std::pair<detail::Stop*, detail::Stop*>& stops, double distance) {
-    distances_between_stops_[stops] = distance;
+    distances_between_stops_.Set(stops.first->id, stops.second->id, distance);
+
+    // Расстояние могло войти в длину уже добавленных маршрутов, проходящих через обе остановки
+    for (const auto bus : stop_to_buses_[stops.first->id]) {
+        if (stop_to_buses_[stops.second->id].count(bus) > 0) {
+            UpdateBusInfo(*bus);
+        }
+    }
+}
+
+// Все заданные расстояния между остановками
+const detail::DistanceTable& Catalogue::GetDistances() const {
+    return distances_between_stops_;
+}
+
+const std::vector<double>& Catalogue::GetRouteDistances(const detail::bus::Bus* bus) const {
+    return bus_route_distances_.at(bus->id);
 }
 
 detail::Stop* Catalogue::FindStop(const std::string_view name) const {
@@ -96,20 +161,30 @@ detail::bus::Bus* Catalogue::FindBus(const std::string_view name) const {
     return nullptr;
 }
 
+// Как и поиск по имени, возвращает изменяемый объект из хранилища
+detail::Stop* Catalogue::GetStop(detail::StopId id) const {
+    return const_cast<detail::Stop*>(&stops_.at(id));
+}
+
+detail::bus::Bus* Catalogue::GetBus(detail::BusId id) const {
+    return const_cast<detail::bus::Bus*>(&buses_.at(id));
+}
+
 detail::bus::Info Catalogue::GetBusInfo(detail::bus::Bus* bus) const {
-    return bus_to_info_.at(bus);
+    return bus_infos_.at(bus->id);
 }
 
 // Получает все автобусы, проходящие через остановку
-const std::set<detail::bus::Bus*, detail::bus::PtrComparator>& Catalogue::GetBusesByStop(std::string_view name) const {
-    static const std::set<detail::bus::Bus*, detail::bus::PtrComparator> empty;
-    auto it = stop_to_buses_.find(name);
+const std::set<detail::bus::Bus*, detail::bus::PtrComparator>& Catalogue::GetBusesByStop(const detail::Stop* stop) const {
+    return stop_to_buses_.at(stop->id);
+}
 
-    if (it != stop_to_buses_.end()) {
-        return it->second;
-    }
-    
-    return empty;
+std::vector<detail::StopDistance> Catalogue::FindStopsInRadius(geo::Coordinates point, double radius) const {
+    return stops_index_.FindInRadius(point, radius);
+}
+
+std::vector<detail::StopDistance> Catalogue::FindNearestStops(geo::Coordinates point, size_t count) const {
+    return stops_index_.FindNearest(point, count);
 }
 
 } // end namespace transport
\ No newline at end of file
@@ -3,40 +3,61 @@
 #include <deque>
 #include <iomanip>
 #include <iostream>
-#include <unordered_set>
 #include <unordered_map>
 #include <set>
+#include <vector>
 
+#include "distance_table.h"
 #include "domain.h"
+#include "stop_index.h"
 
 namespace transport {
 
 class Catalogue {
 public:
     void AddStop(detail::Stop stop);
-    void AddBus(detail::bus::Bus bus);
+    detail::bus::Bus* AddBus(detail::bus::Bus bus);
+    void RemoveBus(detail::bus::Bus* bus);
 
     detail::Stop* FindStop(std::string_view name) const;
     detail::bus::Bus* FindBus(std::string_view name) const;
+    // Удалённые автобусы доступны по номеру, но не по имени
+    detail::Stop* GetStop(detail::StopId id) const;
+    detail::bus::Bus* GetBus(detail::BusId id) const;
     detail::bus::Info GetBusInfo(detail::bus::Bus* bus) const;
 
-    const std::set<detail::bus::Bus*, detail::bus::PtrComparator>& GetBusesByStop(std::string_view name) const;
+    const std::set<detail::bus::Bus*, detail::bus::PtrComparator>& GetBusesByStop(const detail::Stop* stop) const;
     const std::deque<detail::bus::Bus>& GetBuses() const;
     const std::deque<detail::Stop>& GetStops() const;
     double GetDistance(detail::Stop* a, detail::Stop* b) const;
     void SetDistance(const std::pair<detail::Stop*, detail::Stop*>& stops, double distance);
+    const detail::DistanceTable& GetDistances() const;
+    // Расстояния по дорогам от первой остановки автобуса до каждой остановки его маршрута
+    const std::vector<double>& GetRouteDistances(const detail::bus::Bus* bus) const;
+    // Остановки не дальше radius метров от point по возрастанию расстояния
+    std::vector<detail::StopDistance> FindStopsInRadius(geo::Coordinates point, double radius) const;
+    // count ближайших к point остановок по возрастанию расстояния
+    std::vector<detail::StopDistance> FindNearestStops(geo::Coordinates point, size_t count) const;
 
 private:
+    void UpdateBusInfo(const detail::bus::Bus& bus);
+
+    // Номер остановки или автобуса - его позиция в stops_ или buses_,
+    // по нему же индексируются векторы данных об остановках и автобусах
     std::deque<detail::bus::Bus> buses_;
     std::deque<detail::Stop> stops_;
     std::unordered_map<std::string_view, detail::bus::Bus*, detail::Hasher> busname_to_bus_;
     std::unordered_map<std::string_view, detail::Stop*, detail::Hasher> stopname_to_stop_;
-    // Остановка и автобусы, проезжающие через нее
-    std::unordered_map<std::string_view, std::set<detail::bus::Bus*, detail::bus::PtrComparator>> stop_to_buses_; 
-    // Информация о каждом автобусе
-    std::unordered_map<detail::bus::Bus*, detail::bus::Info, detail::Hasher> bus_to_info_; 
+    // Автобусы, проезжающие через остановку, по номеру остановки
+    std::vector<std::set<detail::bus::Bus*, detail::bus::PtrComparator>> stop_to_buses_;
+    // Информация об автобусе по его номеру
+    std::vector<detail::bus::Info> bus_infos_;
+    // Накопленные расстояния вдоль маршрута по номеру автобуса
+    std::vector<std::vector<double>> bus_route_distances_;
     // Расстояние между двумя остановками
-    std::unordered_map<std::pair<detail::Stop*, detail::Stop*>, double, detail::Hasher> distances_between_stops_; 
+    detail::DistanceTable distances_between_stops_;
+    // Остановки по координатам, пополняется в AddStop
+    detail::StopIndex stops_index_;
 };
 
 } // end namespace transport
\ No newline at end of file
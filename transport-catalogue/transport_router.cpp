@@ -1,24 +1,221 @@
 #include "transport_router.h"
+#include "serialization.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <tuple>
 
 namespace transport::router {
 
+namespace {
+
+//  ,       
+struct EdgeKey {
+	graph::VertexId from;
+	graph::VertexId to;
+	size_t kind;
+	detail::BusId bus_id;
+	size_t span_count;
+	double weight;
+
+	auto AsTuple() const {
+		return std::tie(from, to, kind, bus_id, span_count, weight);
+	}
+};
+
+EdgeKey MakeEdgeKey(graph::VertexId from, graph::VertexId to, double weight,
+	const TransportRouter::EdgeInfo& edge_info) {
+	EdgeKey key{ from, to, edge_info.index(), 0, 0, weight };
+	if (const auto* bus_edge = std::get_if<TransportRouter::BusEdge>(&edge_info)) {
+		key.bus_id = bus_edge->bus->id;
+		key.span_count = bus_edge->span_count;
+	}
+	else if (const auto* board_edge = std::get_if<TransportRouter::BoardEdge>(&edge_info)) {
+		key.bus_id = board_edge->bus->id;
+	}
+	else if (const auto* ride_edge = std::get_if<TransportRouter::RideEdge>(&edge_info)) {
+		key.span_count = ride_edge->span_count;
+	}
+	return key;
+}
+
+//    :       
+void SaveRoutingSettings(serialization::OutputArchive& archive, const RoutingSettings& settings) {
+	archive.Write(static_cast<int32_t>(settings.bus_wait_time));
+	archive.Write(settings.bus_velocity);
+	archive.Write(static_cast<uint8_t>(settings.router_mode));
+	archive.Write(static_cast<uint8_t>(settings.graph_model));
+	archive.Write(static_cast<uint64_t>(settings.thread_count));
+}
+
+RoutingSettings LoadRoutingSettings(serialization::InputArchive& archive) {
+	RoutingSettings settings;
+	settings.bus_wait_time = archive.Read<int32_t>();
+	settings.bus_velocity = archive.Read<double>();
+
+	//    - 
+	const auto router_mode = archive.Read<uint8_t>();
+	if (router_mode > static_cast<uint8_t>(graph::RouterMode::CONTRACTION_HIERARCHY)) {
+		throw serialization::FormatError("Unknown router mode");
+	}
+	settings.router_mode = static_cast<graph::RouterMode>(router_mode);
+	const auto graph_model = archive.Read<uint8_t>();
+	if (graph_model > static_cast<uint8_t>(GraphModel::RIDE_CHAINS)) {
+		throw serialization::FormatError("Unknown graph model");
+	}
+	settings.graph_model = static_cast<GraphModel>(graph_model);
+
+	settings.thread_count = static_cast<size_t>(archive.Read<uint64_t>());
+	return settings;
+}
+
+//           
+//     std::invalid_argument
+template <typename Load>
+auto LoadGraphData(Load load) {
+	try {
+		return load();
+	}
+	catch (const std::invalid_argument& error) {
+		throw serialization::FormatError(error.what());
+	}
+}
+
+} // namespace
+
 TransportRouter::TransportRouter(RoutingSettings settings, const Catalogue& catalogue)
-	: settings_(settings) {
+	: settings_(settings)
+	, timetable_(catalogue, GetMetersPerMinute()) {
+	BuildGraph(catalogue);
+	router_ = std::make_unique<graph::Router<double, Graph>>(graph_, settings_.router_mode,
+		settings_.thread_count);
+}
+
+void TransportRouter::Update(const Catalogue& catalogue) {
+	//   ,        
+	const Graph old_graph = std::move(graph_);
+	const std::vector<EdgeInfo> old_edges = std::move(edges_);
+	const std::vector<graph::VertexId> old_bus_first_vertex_ids = std::move(bus_first_vertex_ids_);
+	const size_t old_stop_count = stops_vertex_ids_.size();
+
+	BuildGraph(catalogue);
+	router_->Update(CompareGraphs(catalogue, old_graph, old_edges, old_stop_count, old_bus_first_vertex_ids),
+		settings_.thread_count);
+	//     ,   ,   
+	timetable_ = TimetableRouter(catalogue, GetMetersPerMinute());
+}
+
+void TransportRouter::BuildGraph(const Catalogue& catalogue) {
 	const auto& stops = catalogue.GetStops();
-	const size_t vertex_count = stops.size() * 2;  //     
-	graph_ = graph::DirectedWeightedGraph<double>(vertex_count);
-	vertexes_.resize(vertex_count);
+	size_t vertex_count = stops.size() * 2;  //     
+	if (settings_.graph_model == GraphModel::RIDE_CHAINS) {
+		//         
+		for (const auto& bus : catalogue.GetBuses()) {
+			vertex_count += bus.stops.size();
+		}
+	}
+	GraphBuilder graph(vertex_count);
+	vertexes_.assign(vertex_count, nullptr);
+	edges_.clear();
+
+	AddStopsToGraph(catalogue, graph);
+	AddBusesToGraph(catalogue, graph);
+	FreezeGraph(graph);
+}
+
+TransportRouter::TransportRouter(serialization::InputArchive& archive,
+	const serialization::CatalogueIndex& index)
+	: settings_(LoadRoutingSettings(archive))
+	, graph_(LoadGraphData([&archive] {
+		return Graph::Load(archive);
+	})) {
+	stops_vertex_ids_.resize(archive.Read<uint64_t>());
+	for (size_t i = 0; i < stops_vertex_ids_.size(); ++i) {
+		const auto* stop = index.GetStop(archive.Read<uint32_t>());
+		if (stop->id >= stops_vertex_ids_.size()) {
+			throw serialization::FormatError("Stop id is out of range");
+		}
+		stops_vertex_ids_[stop->id] = archive.Read<StopVertexIds>();
+	}
 
-	AddStopsToGraph(catalogue);
-	AddBusesToGraph(catalogue);
+	vertexes_.resize(archive.Read<uint64_t>());
+	for (auto& stop : vertexes_) {
+		stop = index.GetStop(archive.Read<uint32_t>());
+	}
+	bus_first_vertex_ids_ = archive.ReadVector<graph::VertexId>();
 
-	router_ = std::make_unique<graph::Router<double>>(graph_);
+	edges_.resize(archive.Read<uint64_t>());
+	for (auto& edge_info : edges_) {
+		switch (archive.Read<uint8_t>()) {
+		case 0:
+			edge_info = WaitEdge{};
+			break;
+		case 1: {
+			const auto* bus = index.GetBus(archive.Read<uint32_t>());
+			edge_info = BusEdge{ bus, static_cast<size_t>(archive.Read<uint64_t>()) };
+			break;
+		}
+		case 2:
+			edge_info = BoardEdge{ index.GetBus(archive.Read<uint32_t>()) };
+			break;
+		case 3:
+			edge_info = RideEdge{ static_cast<size_t>(archive.Read<uint64_t>()) };
+			break;
+		default:
+			throw serialization::FormatError("Unknown edge type");
+		}
+	}
+	if (edges_.size() != graph_.GetEdgeCount() || vertexes_.size() != graph_.GetVertexCount()) {
+		throw serialization::FormatError("Router data does not match its graph");
+	}
+
+	router_ = LoadGraphData([this, &archive] {
+		return std::make_unique<graph::Router<double, Graph>>(graph_, archive);
+	});
+	timetable_ = TimetableRouter(archive, index);
+}
+
+void TransportRouter::Save(serialization::OutputArchive& archive,
+	const serialization::CatalogueIndex& index) const {
+	SaveRoutingSettings(archive, settings_);
+	graph_.Save(archive);
+
+	archive.Write(static_cast<uint64_t>(stops_vertex_ids_.size()));
+	for (uint32_t stop_id = 0; stop_id < stops_vertex_ids_.size(); ++stop_id) {
+		archive.Write(stop_id);
+		archive.Write(stops_vertex_ids_[stop_id]);
+	}
+
+	archive.Write(static_cast<uint64_t>(vertexes_.size()));
+	for (const auto* stop : vertexes_) {
+		archive.Write(index.GetStopId(stop));
+	}
+	archive.WriteVector(bus_first_vertex_ids_);
+
+	//  :   EdgeInfo   
+	archive.Write(static_cast<uint64_t>(edges_.size()));
+	for (const auto& edge_info : edges_) {
+		archive.Write(static_cast<uint8_t>(edge_info.index()));
+		if (const auto* bus_edge = std::get_if<BusEdge>(&edge_info)) {
+			archive.Write(index.GetBusId(bus_edge->bus));
+			archive.Write(static_cast<uint64_t>(bus_edge->span_count));
+		}
+		else if (const auto* board_edge = std::get_if<BoardEdge>(&edge_info)) {
+			archive.Write(index.GetBusId(board_edge->bus));
+		}
+		else if (const auto* ride_edge = std::get_if<RideEdge>(&edge_info)) {
+			archive.Write(static_cast<uint64_t>(ride_edge->span_count));
+		}
+	}
+
+	router_->Save(archive);
+	timetable_.Save(archive, index);
 }
 
 std::optional<RouteInfo>
 TransportRouter::FindRoute(const detail::Stop* from, const detail::Stop* to) const {
-	const graph::VertexId vertex_from = stops_vertex_ids_.at(from).out;
-	const graph::VertexId vertex_to = stops_vertex_ids_.at(to).out;
+	const graph::VertexId vertex_from = stops_vertex_ids_.at(from->id).out;
+	const graph::VertexId vertex_to = stops_vertex_ids_.at(to->id).out;
 	const auto route = router_->BuildRoute(vertex_from, vertex_to);
 
 	if (!route) {
@@ -30,16 +227,25 @@ TransportRouter::FindRoute(const detail::Stop* from, const detail::Stop* to) con
 	route_info.items.reserve(route->edges.size());
 
 	for (const auto edge_id : route->edges) {
-		const auto& edge = graph_.GetEdge(edge_id);
-		const auto& bus_edge_info = edges_[edge_id];
+		const auto edge = graph_.GetEdge(edge_id);
+		const auto& edge_info = edges_[edge_id];
 
-		if (bus_edge_info.has_value()) {
+		if (const auto* bus_edge = std::get_if<BusEdge>(&edge_info)) {
 			route_info.items.emplace_back(RouteInfo::BusItem{
-			  bus_edge_info->bus,
+			  bus_edge->bus,
 			  edge.weight,
-			  bus_edge_info->span_count,
+			  bus_edge->span_count,
 			});
 		}
+		else if (const auto* board_edge = std::get_if<BoardEdge>(&edge_info)) {
+			route_info.items.emplace_back(RouteInfo::BusItem{ board_edge->bus });
+		}
+		else if (const auto* ride_edge = std::get_if<RideEdge>(&edge_info)) {
+			//   ,   
+			auto& bus_item = std::get<RouteInfo::BusItem>(route_info.items.back());
+			bus_item.time += edge.weight;
+			bus_item.span_count += ride_edge->span_count;
+		}
 		else {
 			const graph::VertexId vertex_id = edge.from;
 			route_info.items.emplace_back(RouteInfo::WaitItem{
@@ -51,20 +257,69 @@ TransportRouter::FindRoute(const detail::Stop* from, const detail::Stop* to) con
 	return route_info;
 }
 
-void TransportRouter::AddStopsToGraph(const Catalogue& cat) {
+RouteMatrix TransportRouter::ComputeRouteMatrix(const std::vector<const detail::Stop*>& sources,
+	const std::vector<const detail::Stop*>& targets) const {
+	const auto to_vertices = [this](const std::vector<const detail::Stop*>& stops) {
+		std::vector<graph::VertexId> vertices;
+		vertices.reserve(stops.size());
+		for (const auto* stop : stops) {
+			vertices.push_back(stops_vertex_ids_.at(stop->id).out);
+		}
+		return vertices;
+	};
+
+	return RouteMatrix{
+		sources.size(),
+		targets.size(),
+		router_->ComputeWeights(to_vertices(sources), to_vertices(targets)),
+	};
+}
+
+std::vector<detail::StopTime> TransportRouter::FindReachableStops(const detail::Stop* from,
+	double max_time) const {
+	std::vector<detail::StopTime> stop_times;
+	for (const auto& [vertex_id, time] : router_->ComputeWeightsWithin(stops_vertex_ids_.at(from->id).out, max_time)) {
+		//    ,    -  
+		const detail::Stop* stop = vertexes_[vertex_id];
+		if (stops_vertex_ids_[stop->id].out == vertex_id) {
+			stop_times.push_back({ stop, time });
+		}
+	}
+
+	std::sort(stop_times.begin(), stop_times.end(), [](const detail::StopTime& lhs, const detail::StopTime& rhs) {
+		return std::tie(lhs.time, lhs.stop->name) < std::tie(rhs.time, rhs.stop->name);
+	});
+	return stop_times;
+}
+
+std::optional<Journey> TransportRouter::FindJourney(const detail::Stop* from, const detail::Stop* to,
+	double departure_time) const {
+	return timetable_.FindJourney(from, to, departure_time);
+}
+
+double TransportRouter::ComputeRideTime(double distance) const {
+	return distance / GetMetersPerMinute();
+}
+
+double TransportRouter::GetMetersPerMinute() const {
+	return settings_.bus_velocity * 1000.0 / 60;
+}
+
+void TransportRouter::AddStopsToGraph(const Catalogue& cat, GraphBuilder& graph) {
 	graph::VertexId vertex_id = 0;
 	const auto& stops = cat.GetStops();
+	stops_vertex_ids_.resize(stops.size());
 
 	for (const auto& stop : stops) {
-		auto& vertex_ids = stops_vertex_ids_[&stop];
+		auto& vertex_ids = stops_vertex_ids_[stop.id];
 
 		vertex_ids.in = vertex_id++;
 		vertex_ids.out = vertex_id++;
 		vertexes_[vertex_ids.in] = &stop;
 		vertexes_[vertex_ids.out] = &stop;
 
-		edges_.emplace_back(std::nullopt);
-		graph_.AddEdge({
+		edges_.emplace_back(WaitEdge{});
+		graph.AddEdge({
 		  vertex_ids.out,
 		  vertex_ids.in,
 		  static_cast<double> (settings_.bus_wait_time)
@@ -72,41 +327,157 @@ void TransportRouter::AddStopsToGraph(const Catalogue& cat) {
 	}
 }
 
-void TransportRouter::AddBusesToGraph(const Catalogue& cat) {
+void TransportRouter::AddBusesToGraph(const Catalogue& cat, GraphBuilder& graph) {
 	const auto& buses = cat.GetBuses();
+	//      
+	graph::VertexId ride_vertex_id = cat.GetStops().size() * 2;
+	bus_first_vertex_ids_.assign(buses.size(), NO_VERTEX);
 
 	for (const auto& bus : buses) {
-		const auto& bus_stops = bus.stops;
-		const size_t stop_count = bus_stops.size();
-
-		if (stop_count <= 1) {
+		if (bus.stops.size() <= 1) {
 			continue;
 		}
 
-		auto compute_distance_from = [&cat, &bus_stops](size_t stop_idx) {
-			return cat.GetDistance(bus_stops[stop_idx], bus_stops[stop_idx + 1]);
-			};
+		if (settings_.graph_model == GraphModel::RIDE_CHAINS) {
+			bus_first_vertex_ids_[bus.id] = ride_vertex_id;
+			AddBusRideChain(cat, bus, ride_vertex_id, graph);
+			ride_vertex_id += bus.stops.size();
+		}
+		else {
+			AddBusSpans(cat, bus, graph);
+		}
+	}
+}
+
+void TransportRouter::AddBusSpans(const Catalogue& cat, const detail::bus::Bus& bus,
+	GraphBuilder& graph) {
+	const auto& bus_stops = bus.stops;
+	const size_t stop_count = bus_stops.size();
+	//    start  end -   
+	const auto& route_distances = cat.GetRouteDistances(&bus);
+
+	for (size_t start = 0; start < stop_count - 1; ++start) {
+		const graph::VertexId begin = stops_vertex_ids_[bus_stops[start]->id].in;
+
+		for (size_t end = start + 1; end < stop_count; ++end) {
+			edges_.emplace_back(BusEdge{
+				&bus,
+				end - start,
+			});
+
+			graph.AddEdge({
+				begin,
+				stops_vertex_ids_[bus_stops[end]->id].out,
+				ComputeRideTime(route_distances[end] - route_distances[start])
+			});
+		}
+	}
+}
+
+//   :   i- ,  i -> i+1,   i- .
+//      
+void TransportRouter::AddBusRideChain(const Catalogue& cat, const detail::bus::Bus& bus,
+	graph::VertexId first_vertex_id, GraphBuilder& graph) {
+	const auto& bus_stops = bus.stops;
+	const size_t stop_count = bus_stops.size();
+	const auto& route_distances = cat.GetRouteDistances(&bus);
+
+	for (size_t idx = 0; idx < stop_count; ++idx) {
+		const graph::VertexId ride_vertex = first_vertex_id + idx;
+		const auto& stop_vertex_ids = stops_vertex_ids_[bus_stops[idx]->id];
+		vertexes_[ride_vertex] = bus_stops[idx];
+
+		if (idx + 1 < stop_count) {
+			edges_.emplace_back(BoardEdge{ &bus });
+			graph.AddEdge({ stop_vertex_ids.in, ride_vertex, 0.0 });
+
+			edges_.emplace_back(RideEdge{ 1 });
+			graph.AddEdge({
+				ride_vertex,
+				ride_vertex + 1,
+				ComputeRideTime(route_distances[idx + 1] - route_distances[idx])
+			});
+		}
+		if (idx > 0) {
+			edges_.emplace_back(RideEdge{ 0 });
+			graph.AddEdge({ ride_vertex, stop_vertex_ids.out, 0.0 });
+		}
+	}
+}
 
-		for (size_t start = 0; start < stop_count - 1; ++start) {
-			const graph::VertexId begin = stops_vertex_ids_.at(bus_stops[start]).in;
-			size_t total_distance = 0;
+//         
+void TransportRouter::FreezeGraph(const GraphBuilder& graph) {
+	std::vector<graph::EdgeId> new_edge_ids;
+	graph_ = Graph(graph, new_edge_ids);
 
-			for (size_t end = start + 1; end < stop_count; ++end) {
-				total_distance += compute_distance_from(end - 1);
-				edges_.emplace_back(BusEdge{
-					&bus,
-					end - start,
-				});
+	std::vector<EdgeInfo> edges(edges_.size());
+	for (graph::EdgeId edge_id = 0; edge_id < edges_.size(); ++edge_id) {
+		edges[new_edge_ids[edge_id]] = edges_[edge_id];
+	}
+	edges_ = std::move(edges);
+}
 
-				graph_.AddEdge({
-					begin,
-					stops_vertex_ids_.at(bus_stops[end]).out,
-					static_cast<double>(total_distance)
-					  / (settings_.bus_velocity * 1000.0 / 60)
-				});
-			}
+//   ,     .  
+//  ,    ,       .
+// и   :        
+graph::GraphChange TransportRouter::CompareGraphs(const Catalogue& catalogue, const Graph& old_graph,
+	const std::vector<EdgeInfo>& old_edges, size_t old_stop_count,
+	const std::vector<graph::VertexId>& old_bus_first_vertex_ids) const {
+	graph::GraphChange change;
+	change.new_vertex_ids.assign(old_graph.GetVertexCount(), NO_VERTEX);
+	for (graph::VertexId vertex_id = 0; vertex_id < old_stop_count * 2; ++vertex_id) {
+		change.new_vertex_ids[vertex_id] = vertex_id;
+	}
+	const auto& buses = catalogue.GetBuses();
+	for (detail::BusId bus_id = 0; bus_id < old_bus_first_vertex_ids.size(); ++bus_id) {
+		const graph::VertexId old_first = old_bus_first_vertex_ids[bus_id];
+		const graph::VertexId new_first = bus_first_vertex_ids_[bus_id];
+		if (old_first == NO_VERTEX || new_first == NO_VERTEX) {
+			continue;
+		}
+		for (size_t idx = 0; idx < buses[bus_id].stops.size(); ++idx) {
+			change.new_vertex_ids[old_first + idx] = new_first + idx;
+		}
+	}
+
+	std::vector<std::pair<EdgeKey, graph::EdgeId>> old_keys;
+	old_keys.reserve(old_edges.size());
+	for (graph::EdgeId edge_id = 0; edge_id < old_edges.size(); ++edge_id) {
+		const auto edge = old_graph.GetEdge(edge_id);
+		const graph::VertexId from = change.new_vertex_ids[edge.from];
+		const graph::VertexId to = change.new_vertex_ids[edge.to];
+		if (from != NO_VERTEX && to != NO_VERTEX) {
+			old_keys.emplace_back(MakeEdgeKey(from, to, edge.weight, old_edges[edge_id]), edge_id);
+		}
+	}
+	std::vector<std::pair<EdgeKey, graph::EdgeId>> new_keys;
+	new_keys.reserve(edges_.size());
+	for (graph::EdgeId edge_id = 0; edge_id < edges_.size(); ++edge_id) {
+		const auto edge = graph_.GetEdge(edge_id);
+		new_keys.emplace_back(MakeEdgeKey(edge.from, edge.to, edge.weight, edges_[edge_id]), edge_id);
+	}
+	const auto key_less = [](const auto& lhs, const auto& rhs) {
+		return lhs.first.AsTuple() < rhs.first.AsTuple();
+	};
+	std::sort(old_keys.begin(), old_keys.end(), key_less);
+	std::sort(new_keys.begin(), new_keys.end(), key_less);
+
+	//   ;     
+	change.new_edge_ids.assign(old_edges.size(), graph::GraphChange::REMOVED);
+	auto old_it = old_keys.begin();
+	for (const auto& new_key : new_keys) {
+		while (old_it != old_keys.end() && key_less(*old_it, new_key)) {
+			++old_it;
+		}
+		if (old_it != old_keys.end() && !key_less(new_key, *old_it)) {
+			change.new_edge_ids[old_it->second] = new_key.second;
+			++old_it;
+		}
+		else {
+			change.added_edges.push_back(new_key.second);
 		}
 	}
+	return change;
 }
 
-} // namespace transport::router
\ No newline at end of file
+} // namespace transport::router
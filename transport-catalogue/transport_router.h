@@ -1,19 +1,34 @@
 #pragma once
 
 #include "router.h"
+#include "timetable_router.h"
 #include "transport_catalogue.h"
 
 #include <memory>
 #include <optional>
-#include <unordered_map>
 #include <variant>
 #include <vector>
 
+namespace serialization {
+class CatalogueIndex;
+class InputArchive;
+class OutputArchive;
+}  // namespace serialization
+
 namespace transport::router {
 
+enum class GraphModel {
+    SPAN_EDGES,   // an edge for every pair of stops on a bus, O(n^2) per bus
+    RIDE_CHAINS,  // a chain of vertices per bus with boarding and alighting edges, O(n) per bus
+};
+
 struct RoutingSettings {
     int bus_wait_time = 0;
     double bus_velocity = 0;
+    graph::RouterMode router_mode = graph::RouterMode::ALL_PAIRS;
+    GraphModel graph_model = GraphModel::SPAN_EDGES;
+    // Threads building the ALL_PAIRS route table
+    size_t thread_count = 1;
 };
 
 struct RouteInfo {
@@ -34,6 +49,15 @@ struct RouteInfo {
     std::vector<Item> items;
 };
 
+// Travel times between stops without the routes themselves, row by row:
+// total_times[i * target_count + j] is the time from the i-th source to the j-th target,
+// nullopt if that target cannot be reached
+struct RouteMatrix {
+    size_t source_count = 0;
+    size_t target_count = 0;
+    std::vector<std::optional<double>> total_times;
+};
+
 class TransportRouter {
 public:
     struct StopVertexIds {
@@ -41,26 +65,78 @@ public:
         graph::VertexId out;
     };
 
+    struct WaitEdge {};
+
     struct BusEdge {
         const detail::bus::Bus* bus;
         size_t span_count;
     };
 
+    struct BoardEdge {
+        const detail::bus::Bus* bus;
+    };
+
+    // Continues the ride started by the last BoardEdge
+    struct RideEdge {
+        size_t span_count;
+    };
+
+    using EdgeInfo = std::variant<WaitEdge, BusEdge, BoardEdge, RideEdge>;
+
     TransportRouter() = default;
     TransportRouter(RoutingSettings settings, const Catalogue& catalogue);
+    // Restores a router written by Save without rebuilding the graph or route tables
+    TransportRouter(serialization::InputArchive& archive, const serialization::CatalogueIndex& index);
+
+    void Save(serialization::OutputArchive& archive, const serialization::CatalogueIndex& index) const;
+
+    // Rebuilds the graph from the changed catalogue and repairs only the affected route data.
+    // Stops may only be added, buses added or removed, road distances changed
+    void Update(const Catalogue& catalogue);
 
     std::optional<RouteInfo> FindRoute(const detail::Stop* from, const detail::Stop* to) const;
+    // One search per source instead of one per pair, see graph::Router::ComputeWeights
+    RouteMatrix ComputeRouteMatrix(const std::vector<const detail::Stop*>& sources,
+                                   const std::vector<const detail::Stop*>& targets) const;
+    // Stops reachable from stop from within max_time minutes, by increasing travel time.
+    // A single search bounded by max_time, see graph::Router::ComputeWeightsWithin
+    std::vector<detail::StopTime> FindReachableStops(const detail::Stop* from, double max_time) const;
+    // Earliest arrival by bus timetables when leaving stop from at departure_time,
+    // see TimetableRouter. Buses without departures do not take part
+    std::optional<Journey> FindJourney(const detail::Stop* from, const detail::Stop* to,
+                                       double departure_time) const;
 
 private:
-    void AddStopsToGraph(const Catalogue& catalogue);
-    void AddBusesToGraph(const Catalogue& catalogue);
+    using Graph = graph::CompressedGraph<double>;
+    using GraphBuilder = graph::DirectedWeightedGraph<double>;
+
+    static constexpr graph::VertexId NO_VERTEX = graph::GraphChange::REMOVED;
+
+    double ComputeRideTime(double distance) const;
+    double GetMetersPerMinute() const;
+
+    void BuildGraph(const Catalogue& catalogue);
+    void AddStopsToGraph(const Catalogue& catalogue, GraphBuilder& graph);
+    void AddBusesToGraph(const Catalogue& catalogue, GraphBuilder& graph);
+    void AddBusSpans(const Catalogue& catalogue, const detail::bus::Bus& bus, GraphBuilder& graph);
+    void AddBusRideChain(const Catalogue& catalogue, const detail::bus::Bus& bus,
+                         graph::VertexId first_vertex_id, GraphBuilder& graph);
+    void FreezeGraph(const GraphBuilder& graph);
+    // Matches the previous graph against the current one
+    graph::GraphChange CompareGraphs(const Catalogue& catalogue, const Graph& old_graph,
+                                     const std::vector<EdgeInfo>& old_edges, size_t old_stop_count,
+                                     const std::vector<graph::VertexId>& old_bus_first_vertex_ids) const;
 
     RoutingSettings settings_;
-    graph::DirectedWeightedGraph<double> graph_;
-    std::unique_ptr<graph::Router<double>> router_;
-    std::unordered_map<const detail::Stop*, StopVertexIds, detail::Hasher> stops_vertex_ids_;
+    Graph graph_;
+    std::unique_ptr<graph::Router<double, Graph>> router_;
+    // Indexed by stop id
+    std::vector<StopVertexIds> stops_vertex_ids_;
     std::vector<const detail::Stop*> vertexes_;
-    std::vector<std::optional<BusEdge>> edges_;
+    std::vector<EdgeInfo> edges_;
+    // RIDE_CHAINS: first vertex of the ride chain by bus id, NO_VERTEX for buses without one
+    std::vector<graph::VertexId> bus_first_vertex_ids_;
+    TimetableRouter timetable_;
 };
 
 }  // namespace transport::router
\ No newline at end of file